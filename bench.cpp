@@ -0,0 +1,262 @@
+/***************************************************************************
+* File: bench.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Runs fcfs, rr, spn, srt, hrrn and mlfq over a sweep of task counts, memory block counts and
+          size/duration distributions and writes one JSON record per case with simulated
+          tasks per second, ns per dispatch and peak RSS. Given a baseline written by an
+          earlier run it reports the cases that got slower.
+
+* timeCase - Times one scheduling function on one task stream and memory layout.
+
+* peakRss - Peak resident set size of the process so far.
+
+* printCase, readBaseline - Write and read the JSON records.
+
+* Build: g++ -O2 -std=c++17 -pthread bench.cpp simulator.cpp -o bench
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+#include <chrono>
+#include <sys/resource.h>
+
+struct benchCase {																											//Structure to hold one benchmark case and its measurements
+    char policy[16];																										//Scheduling function, rr carries its quantum
+    long long tasks;																										//Tasks in the task stream
+    int blocks;																												//Memory blocks
+    char dist[16];																											//Size and duration distribution, loops x ulimit
+    long long dispatches;																									//Dispatches in one run
+    double tasksPerSec;																										//Simulated tasks per second
+    double nsPerDispatch;																									//Wall time per dispatch
+    long peakRss;																											//Peak resident set size in KB after the case
+};
+
+const int DISTS = 3;
+const int distLoops[DISTS] = {4, 2, 16};																					//Uniform values summed per size or duration
+const int distUlimit[DISTS] = {4, 8, 2};																					//Max of each uniform value, every task still fits in 16
+
+/***************************************************************************
+* long peakRss()
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the peak resident set size of the process so far. It never
+               goes down, so cases are run from the smallest task count up.
+* Parameters:
+* peakRss   O/P long - Peak resident set size in KB
+***************************************************************************/
+
+long peakRss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/***************************************************************************
+* void timeCase(struct runArena &arena, struct taskSource &source, int p, const struct simConfig &config, int reps, struct benchCase &bc)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs one scheduling function on a task stream reps times and keeps
+               the fastest run, so a busy machine only ever makes a case look
+               slower by less.
+* Parameters:
+* arena     I/P struct runArena - Buffers the runs reuse
+* source    I/P struct taskSource - The task stream
+* p         I/P int - The policy to run
+* config    I/P struct simConfig - Memory layout, placement algorithm and quantum
+* reps      I/P int - Times to run the case
+* bc        O/P struct benchCase - Where the measurements are stored
+***************************************************************************/
+
+void timeCase(struct runArena &arena, struct taskSource &source, int p, const struct simConfig &config, int reps, struct benchCase &bc)
+{
+    double best = -1;
+    for (int r = 0; r < reps; r++){
+        struct results res;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        runPolicy(p, arena, source, config, res);
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+        if (best < 0 || ns < best)
+            best = ns;
+    }
+    bc.dispatches = arena.sim.dispatches;
+    bc.tasksPerSec = bc.tasks / (best * 1e-9);
+    bc.nsPerDispatch = best / bc.dispatches;
+    bc.peakRss = peakRss();
+}
+
+/***************************************************************************
+* void printCase(FILE *out, const struct benchCase &bc, bool last)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Writes a case as one line of a JSON array. Keeping every record on
+               its own line lets readBaseline and diff work line by line.
+* Parameters:
+* out   I/P FILE * - Where to write
+* bc    I/P struct benchCase - The case
+* last  I/P bool - True for the last record of the array
+***************************************************************************/
+
+void printCase(FILE *out, const struct benchCase &bc, bool last)
+{
+    fprintf(out, "{\"policy\":\"%s\",\"tasks\":%lld,\"blocks\":%d,\"dist\":\"%s\",\"dispatches\":%lld,"
+            "\"tasks_per_sec\":%.0f,\"ns_per_dispatch\":%.2f,\"peak_rss_kb\":%ld}%s\n",
+            bc.policy, bc.tasks, bc.blocks, bc.dist, bc.dispatches, bc.tasksPerSec, bc.nsPerDispatch, bc.peakRss,
+            last ? "" : ",");
+}
+
+/***************************************************************************
+* bool readBaseline(const char *path, vector<struct benchCase> &cases)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads the records of a JSON array written by printCase.
+* Parameters:
+* path          I/P const char * - The baseline file
+* cases         O/P vector<struct benchCase> - The records read
+* readBaseline  O/P bool - False if the file cannot be opened
+***************************************************************************/
+
+bool readBaseline(const char *path, vector<struct benchCase> &cases)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+        return false;
+    char line[512];
+    while (fgets(line, sizeof(line), in)){
+        struct benchCase bc;
+        if (sscanf(line, "{\"policy\":\"%15[^\"]\",\"tasks\":%lld,\"blocks\":%d,\"dist\":\"%15[^\"]\",\"dispatches\":%lld,"
+                   "\"tasks_per_sec\":%lf,\"ns_per_dispatch\":%lf,\"peak_rss_kb\":%ld",
+                   bc.policy, &bc.tasks, &bc.blocks, bc.dist, &bc.dispatches, &bc.tasksPerSec, &bc.nsPerDispatch, &bc.peakRss) == 8){
+            cases.push_back(bc);
+        }
+    }
+    fclose(in);
+    return true;
+}
+
+/***************************************************************************
+* int main( int argc, char *argv[] )
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sweeps the task count, the amount of memory blocks and the size
+               and duration distribution for every scheduling function and
+               writes the measurements as a JSON array. With a baseline, cases
+               whose ns per dispatch grew by more than the tolerance, or whose
+               dispatch count changed, are listed on stderr and count as
+               regressions.
+* Parameters:
+* argc I/P int The number of arguments on the command line
+* argv I/P char *[] The arguments on the command line, -r <reps> runs per case, -q <quantum>
+                    the round robin quantum, -s <seed> the seed, -o <file> where to write
+                    the JSON, -c <file> a baseline to compare with and -x <percent> the
+                    slowdown allowed before a case counts as a regression
+* main O/P int 0, or 1 if a case regressed against the baseline
+**************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    int reps = 3;
+    uint64_t seed = 1;
+    const char *outPath = NULL;
+    const char *basePath = NULL;
+    double tolerance = 10;
+    struct simConfig config;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc){
+            reps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc){
+            config.quantum = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc){
+            basePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc){
+            tolerance = atof(argv[++i]);
+        }
+    }
+    if (reps < 1 || config.quantum < 1){
+        cout << "Reps and quantum must be at least 1" << endl;
+        return 1;
+    }
+    vector<struct benchCase> baseline;
+    if (basePath && !readBaseline(basePath, baseline)){
+        cout << "Cannot read baseline " << basePath << endl;
+        return 1;
+    }
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (out == NULL){
+        cout << "Cannot write " << outPath << endl;
+        return 1;
+    }
+
+    const long long taskCounts[] = {1000, 10000, 100000};
+    const int blockCounts[] = {4, 16, 64};
+    const char *names[POLICIES] = {"fcfs", "rrq", "spn", "srt", "hrrn", "mlfq"};
+    int total = 3 * 3 * DISTS * POLICIES;
+    int done = 0, regressions = 0;
+    struct runArena arena;
+    struct workload work;
+    fprintf(out, "[\n");
+    for (long long tasks : taskCounts){
+        for (int d = 0; d < DISTS; d++){
+            struct normalSource src;																						//Same stream for every case of this task count
+            seedStream(src.rng, seed, 0);
+            src.loops = distLoops[d];
+            src.ulimit = distUlimit[d];
+            setTasks(work, src, tasks);
+            struct taskSource source;
+            source.work = &work;
+            source.total = tasks;
+            for (int m : blockCounts){
+                config.blocks.clear();
+                for (int j = 0; j < m; j++){																				//Repeat the 16, 16, 16, 8 layout
+                    config.blocks.push_back(j % 4 == 3 ? 8 : 16);
+                }
+                for (int p = 0; p < POLICIES; p++){
+                    struct benchCase bc;
+                    if (p == RR_POLICY || p == MLFQ_POLICY)
+                        snprintf(bc.policy, sizeof(bc.policy), "%s%d", names[p], config.quantum);
+                    else
+                        snprintf(bc.policy, sizeof(bc.policy), "%s", names[p]);
+                    snprintf(bc.dist, sizeof(bc.dist), "%dx%d", distLoops[d], distUlimit[d]);
+                    bc.tasks = tasks;
+                    bc.blocks = m;
+                    timeCase(arena, source, p, config, reps, bc);
+                    printCase(out, bc, ++done == total);
+                    for (const struct benchCase &base : baseline){															//Compare with the same case of the baseline
+                        if (strcmp(base.policy, bc.policy) != 0 || strcmp(base.dist, bc.dist) != 0
+                            || base.tasks != bc.tasks || base.blocks != bc.blocks)
+                            continue;
+                        bool regressed = false;
+                        if (base.dispatches != bc.dispatches){																//The engine no longer does the same work
+                            cerr << bc.policy << " tasks=" << bc.tasks << " blocks=" << bc.blocks << " dist=" << bc.dist
+                                 << ": dispatches changed from " << base.dispatches << " to " << bc.dispatches << endl;
+                            regressed = true;
+                        }
+                        double change = (bc.nsPerDispatch / base.nsPerDispatch - 1) * 100;
+                        if (change > tolerance){
+                            cerr << bc.policy << " tasks=" << bc.tasks << " blocks=" << bc.blocks << " dist=" << bc.dist
+                                 << ": " << fixed << setprecision(1) << change << "% slower per dispatch" << endl;
+                            regressed = true;
+                        }
+                        regressions += regressed;
+                    }
+                }
+            }
+        }
+    }
+    fprintf(out, "]\n");
+    if (out != stdout)
+        fclose(out);
+    if (basePath){
+        cerr << regressions << " of " << total << " cases regressed" << endl;
+    }
+    return regressions > 0;
+}
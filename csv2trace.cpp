@@ -0,0 +1,136 @@
+/***************************************************************************
+* File: csv2trace.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Converts a CSV job trace with one arrival time, memory size and service time per
+          line into the binary trace format the simulator replays with -r.
+
+* parseLine - Reads one CSV line into a trace record.
+
+* Build: g++ -O2 -std=c++17 -pthread csv2trace.cpp simulator.cpp -o csv2trace
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+
+/***************************************************************************
+* int parseLine(const char *line, struct traceRecord &rec)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads a line of the form arrival,size,duration. Blank lines and
+               lines starting with # are skipped, and so is a first line that
+               does not start with a number, which is taken to be a header.
+* Parameters:
+* line      I/P const char * - The line
+* rec       O/P struct traceRecord - The task read
+* parseLine O/P int - 1 if a task was read, 0 if the line is skipped, -1 if it is bad
+***************************************************************************/
+
+int parseLine(const char *line, struct traceRecord &rec)
+{
+    while (*line == ' ' || *line == '\t')
+        line++;
+    if (*line == '\0' || *line == '\n' || *line == '\r' || *line == '#')
+        return 0;
+    unsigned long long arrival, size, duration;
+    if (sscanf(line, "%llu , %llu , %llu", &arrival, &size, &duration) != 3)
+        return -1;
+    if (size < 1 || size > UINT32_MAX || duration < 1 || duration > UINT32_MAX)
+        return -1;
+    rec.arrival = arrival;
+    rec.size = size;
+    rec.duration = duration;
+    return 1;
+}
+
+/***************************************************************************
+* int main( int argc, char *argv[] )
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Streams the CSV into the binary trace one record at a time, so
+               traces of any length convert in constant memory. The header is
+               written last, once the record count and the largest size and
+               service time are known. Arrival times have to be sorted.
+* Parameters:
+* argc I/P int The number of arguments on the command line
+* argv I/P char *[] The CSV file and the trace file to write
+* main O/P int 0 on success, 1 on a bad line or an I/O error
+**************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3){
+        cout << "Usage: csv2trace <trace.csv> <trace.bin>" << endl;
+        return 1;
+    }
+    FILE *in = fopen(argv[1], "r");
+    if (in == NULL){
+        cout << "Cannot read " << argv[1] << endl;
+        return 1;
+    }
+    FILE *out = fopen(argv[2], "wb");
+    if (out == NULL){
+        cout << "Cannot write " << argv[2] << endl;
+        fclose(in);
+        return 1;
+    }
+
+    struct traceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(struct traceRecord);
+    fwrite(&header, sizeof(header), 1, out);																				//Held in place until the counts are known
+
+    char line[256];
+    long long lineNo = 0;
+    uint64_t lastArrival = 0;
+    int status = 0;
+    while (fgets(line, sizeof(line), in)){
+        lineNo++;
+        struct traceRecord rec;
+        int got = parseLine(line, rec);
+        if (got == -1 && lineNo == 1){																						//Column names
+            continue;
+        }
+        if (got == -1){
+            cout << "Line " << lineNo << ": expected arrival,size,duration with size and duration at least 1" << endl;
+            status = 1;
+            break;
+        }
+        if (got == 0){
+            continue;
+        }
+        if (header.count > 0 && rec.arrival < lastArrival){
+            cout << "Line " << lineNo << ": arrival times have to be sorted" << endl;
+            status = 1;
+            break;
+        }
+        lastArrival = rec.arrival;
+        if (rec.size > header.maxSize)
+            header.maxSize = rec.size;
+        if (rec.duration > header.maxDuration)
+            header.maxDuration = rec.duration;
+        if (fwrite(&rec, sizeof(rec), 1, out) != 1){
+            cout << "Cannot write " << argv[2] << endl;
+            status = 1;
+            break;
+        }
+        header.count++;
+    }
+    fclose(in);
+    if (status == 0){
+        rewind(out);
+        if (fwrite(&header, sizeof(header), 1, out) != 1){
+            cout << "Cannot write " << argv[2] << endl;
+            status = 1;
+        }
+    }
+    if (fclose(out) != 0)
+        status = 1;
+    if (status != 0){
+        remove(argv[2]);
+        return 1;
+    }
+    cout << header.count << " tasks, largest size " << header.maxSize << ", longest service time " << header.maxDuration << endl;
+    return 0;
+}
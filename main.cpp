@@ -2,683 +2,414 @@
 * File: main.cpp
 * Author: Venkata Bapanapalli
 * Procedures:
-* main  - Runs 1000 experiments calling each algorithm function fcfs, rrq1, spn and srt
-          and displays the average and relative average turn around time for each algorithm.
+* main  - Runs 1000 experiments calling each algorithm function fcfs, rr, spn, srt, hrrn and mlfq
+          and displays the average and relative average turn around time for each algorithm,
+          followed by their p50, p90, p99, p99.9 and max.
 
- * uniform   - uniform random number generator, used to generate random numbers for the randomization
-              of task size and duration.
-
-* normal    - normal random number generator, used to generate random numbers for the randomization
-              of task size and duration.
-
-* fcfs  - Function will use the first-fit algorithm to place tasks from the task info stream
-          into memory. The function then does scheduling using the first come first serve
-          algorithm.
-
-* rrq1 - Function will use the worst-fit algorithm to place tasks from the task info stream
-         into memory. The function then does scheduling using the round robin quantum 1 algorithm.
-
-* spn   - Function will use the next-fit algorithm to place tasks from the task info stream
-          into memory. The function then does scheduling using the shortest process next algorithm.
-
-* srt   - Function will use the best-fit algorithm to place tasks from the task info stream
-          into memory. The function then does scheduling using the shortest remaining time
-          algorithm.
-
-* setTasks - Function will set task duration and task size of a value between 1-16. All the tasks
-              that have a task size or duration that is less than 1 is set to 1.
-***************************************************************************/
-#include <iostream>
-#include <time.h>
-#include <stdlib.h>
-#include <iomanip>
-
-using namespace std;
-int location = 0, numTasks = 1000;
-double fcfsTA = 0, fcfsRTA = 0, rrTA = 0, rrRTA = 0, spnTA = 0, spnRTA = 0, srtTA = 0, srtRTA = 0;						    //Variables used for results
-
-struct taskInfo {     																									    //Structure to hold task information
-    int size;																										        //Task size
-    int duration;																									        //Task duration
-    int flag = -1;																											//Task flag used to determine if a task has been processed or not
-    int ignore = 0; 																										//Used to make sure quantum remains 1
-    int quantumStarted = 0;																									//Used to determine if quantum has started
-    int blockLoc;																									        //Location of task in memory
-    int spent;																										        //Time spent to execute
-    int received = 0;																										//Time of when the task was received
-    int start = 0;																											//Holds the time of when task was started
-    int finish = 0;																											//Holds the time of when task was finished
-    int turnAround = 0;																										//Holds the task's turnaround time
-    double relative = 0;																									//Process relative turn around time
-};
-
-struct FCFS{																												//Struct to store FCFS results
-    double ttat = 0;
-    double rtat = 0;
-};
-
-struct RRQ1{																												//Struct to store RRQ1 results
-    double ttat = 0;
-    double rtat = 0;
-};
-
-struct SPN{																													//Struct to store SPN results
-    double ttat = 0;
-    double rtat = 0;
-};
-
-struct SRT{																													//Struct to store SRT results
-    double ttat = 0;
-    double rtat = 0;
-};
-
-struct FCFS fcfsResults;																									//Creating structure to hold FCFS results
-struct SPN spnResults;																										//Creating structure to hold SPN results
-struct RRQ1 rrResults;																										//Creating structure to hold RRQ1 results
-struct SRT srtResults;																										//Creating structure to hold SRT results
-
-/***************************************************************************
-* void uniform(int lo, int hi)
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: generates uniform random integers of values between lo and hi.
-* Parameters:
-* lo    I/P int - min value to generate.
-* hi    I/P int - max value to generate.
-***************************************************************************/
-
-int uniform(int lo, int hi)
-{
-    int x, y = hi - lo, z = RAND_MAX / y;
-    while((x = random()) > y * z);                                                                                          //Uses random() to generate a number between the ideal range
-    return x / z + lo;
-}
-
-/***************************************************************************
-* int normal(int loops, int ulimit)
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: generates normal random integers of values between lo and hi.
-* Parameters:
-* loops     I/P int - number of loops to do for loop.
-* ulimit    I/P int - max  value to generate.
+* Build: g++ -O2 -std=c++17 -pthread main.cpp simulator.cpp -o simulator
+         add -DSIM_STATS for the per run counters and timers
 ***************************************************************************/
-
-int normal(int loops, int ulimit)
-{
-    int x = 0;
-    for(int i = 0; i < loops; i++)                                                                                          //Loops four times and generates a random number between 1-16
-    {
-        x += uniform(0, ulimit);
-    }
-    return x;
-}
+#include "simulator.h"
 
 /***************************************************************************
-* void setTasks( struct taskInfo tasks[], int memBlocks[])
+* int main( int argc, char *argv[] )
 * Author: Venkata Bapanapalli
 * Date: 3 May 2020
-* Description: Initializes the tasks in the tasks array with random size and duration
-               of a value between 1-16 and creates an array for memory blocks.
+* Description: Runs the six process scheduling algorithms on each experiment's
+			   task stream in order to generate results regarding the average
+			   turnaround time and the average relative turnaround time. Each
+			   round runs as a pipeline: a generator thread draws the task
+			   streams BATCH_LANES experiments at a time, the workers run the
+			   policies on them and this thread sums the result slots in
+			   experiment order as batches finish, so the results do not depend
+			   on the amount of threads. With a target
+			   interval width the experiments run in rounds until every interval
+			   is narrow enough. Every policy of an experiment sees the same task
+			   stream, so paired differences get their own, tighter, intervals.
+			   Fcfs and spn run BATCH_LANES experiments at a time in lock-step
+			   when the memory layout is small enough, see runBatch.
+			   With a checkpoint file the totals are saved after every round, or
+			   every -i experiments within a round, and a restarted run picks up
+			   from the last save. The intervals are only checked at the end of a
+			   round, so a run stops after the same experiments with or without
+			   a checkpoint file.
+			   The results regarding these calculations are displayed at the end.
 * Parameters:
-* tasks[]       I/P struct taskInfo - Array struct of tasks in the task stream
-* memBlocks[]   I/P int -  An array that represents the 56 units of memory in blocks
-***************************************************************************/
-
-int setTasks(struct taskInfo tasks[], int memBlocks[])
+* argc I/P int The number of arguments on the command line
+* argv I/P char *[] The arguments on the command line, -q <quantum> sets the round robin quantum
+                    and the top mlfq level's quantum,
+                    -t <threads> the amount of worker threads, -s <seed> the seed,
+                    -b <blocks> the memory layout, -f first|next|best|worst the placement,
+                    -a blocks|holes|buddy the memory model, where holes and buddy
+                    make one memory as big as the layout, -z <cost> compacts the
+                    holes when only they together hold a task, for cost time
+                    units per unit of memory moved,
+                    -n <tasks> the tasks per experiment, -w <window> turns on streaming
+                    with at most window tasks waiting for memory and -r <trace> replays
+                    a binary trace written by csv2trace once instead of the experiments,
+                    -o <file> writes every finished task to a columnar file, -e <width>
+                    and -d <width> keep running experiments until the 95% confidence
+                    interval of every policy's avg turn around time, or of the paired
+                    difference of every two policies, is narrower than width, and
+                    -m <experiments> caps how many that can take, and in a -DSIM_STATS
+                    build -p <file> writes the counters of every run as JSON lines.
+                    -c <file> saves a checkpoint at most every -i <experiments> and
+                    resumes from it when it is there, -i does not change where -e and
+                    -d stop
+* main O/P int Status code (not currently used)
+**************************************************************************/
+int main(int argc, char *argv[])
 {
-    for( int j=0; j < numTasks; j++)                                                                                        // Randomize the sizes and durations of 1000 tasks
-    {
-        tasks[j] = *new taskInfo;
-        tasks[j].size = normal(4,4);
-        if( tasks[j].size < 1 )
-            tasks[j].size = 1;
-        tasks[j].duration = normal(4,4);
-        if( tasks[j].duration < 1 )
-            tasks[j].duration = 1;
-    }
-    memBlocks[0] = 16;																									    // Make memory blocks of size 16, 16, 16, and 8 to equal free memory of 56
-    memBlocks[1] = 16;
-    memBlocks[2] = 16;
-    memBlocks[3] = 8;
-}
-
-/***************************************************************************
-* void srt(int memBlocks[], int m, struct taskInfo process[])
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: Tasks from the taskInfo stream are processed using the memory
-               partitioning algorithm and stored into memory. Then scheduling is
-               performed on the tasks using the srt algorithm. Finally, the avg
-               turnaround time and average relative turn around time is determined
-               for all tasks.
-
-* Parameters:
-* memBlocks[]   I/P int - Array representing the memory blocks
-* m             I/P int - The amount of blocks in memory
-* process[]     I/P struct taskInfo - The array of processes filled with random values
-***************************************************************************/
-
-void srt(int memBlocks[], int m, struct taskInfo process[]){
-    location = 0;
-    int newReceivedTime = 0, n = numTasks;;
-    bool processed, completed = false;
-    while (!completed){																							            //Loop until all tasks are processed
-        for (int i = 0; i < n; i++){ 																						//First fit algorithm
-            completed = true;
-            processed = false;
-            if (process[i].flag == -1){																						//Process tasks with flag of -1
-                for (int j = 0; j < m; j++){ 																				//For all the blocks in memory
-                    if (memBlocks[j] >= process[i].size){ 															        //If allocation is possible
-                        process[i].flag = 1;																				//Set to 1 meaning allocated
-                        process[i].received = newReceivedTime;																//Set the process received time
-                        memBlocks[j] -= process[i].size;																    //Reduce  block size
-                        process[i].blockLoc = j;																		    //Update block location in the struct
-                        processed = true;
-                        break;
-                    }
-                }
-                int min = 2147483640;
-                if (!processed){																					        //If the process was unable to be allocated
-                    for (int l = 0; l < n; l++)																				//Finds the process in memory the shortest service time
-                    {
-                        if (process[l].flag == 1){
-                            if (process[l].duration < min)
-                            {
-                                min = process[l].duration;
-                                location = l;
-                            }
-                        }
-                    }
-                    process[location].flag = 2; 																			//Mark task as completed
-                    memBlocks[process[location].blockLoc] += process[location].size; 							            //Update the block
-                    process[location].start = newReceivedTime;																//Set the start time
-                    process[location].finish = process[location].start + process[location].duration;					    //Set the finish time
-                    process[location].turnAround = process[location].finish - process[location].received;					//Calculate the turn around time
-                    process[location].relative = (double)process[location].turnAround / process[location].duration;		    //Calculate the relative turn around time
-                    newReceivedTime = process[location].finish;																//Update the new received time variable
-                }
-            }
-            for (int j = 0; j < n; j++){																					//Checking if all tasks have been processed
-                if (process[j].flag == -1){																					//If everything has not been processed, ensure the loop keeps executing
-                    completed = false;
-                }
+    struct simConfig config;																								//Memory layout, placement algorithm and quantum
+    int loops = 50;
+    int threads = thread::hardware_concurrency();																			//Worker threads, one per core by default
+    uint64_t seed = 1;																										//Seed of the random number streams
+    double meanWidth = 0;																									//Widest confidence interval allowed for a policy's avg turn around time, 0 for a fixed amount of experiments
+    double diffWidth = 0;																									//Widest confidence interval allowed for the difference of two policies, 0 for a fixed amount of experiments
+    int maxLoops = 100000;																									//Most experiments to run when stopping on the confidence intervals
+    const char *tracePath = NULL;																							//Binary trace to replay, NULL to generate experiments
+    const char *outPath = NULL;																								//Per task output file, NULL for none
+    const char *statsPath = NULL;																							//Counters of every run, NULL for none
+    const char *checkPath = NULL;																							//Checkpoint to resume from and keep up to date, NULL for none
+    int every = 100;																										//Most experiments between checkpoints
+
+    for (int i = 1; i < argc; i++){																							//Read options from the command line
+        if (strcmp(argv[i], "-q") == 0 && i + 1 < argc){
+            config.quantum = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc){
+            if (!parseBlocks(argv[++i], config.blocks)){
+                cout << "Memory layout must be a list of block sizes such as 16,16,16,8 or 3x16,8" << endl;
+                return 1;
             }
         }
-    }
-    bool memNotEmpty = true;
-    while (memNotEmpty){																							        //Process all tasks left in memory
-        int min = 2147483640;
-        location = -1;
-        memNotEmpty = false;
-        for (int l = 0; l < n; l++)																							//Find the process in memory with the shortest service time
-        {
-            if (process[l].flag == 1){
-                if (process[l].duration < min)
-                {
-                    min = process[l].duration;
-                    location = l;
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc){
+            const char *fits[] = {"first", "next", "best", "worst"};
+            i++;
+            config.fit = -1;
+            for (int f = FIRST_FIT; f <= WORST_FIT; f++){
+                if (strcmp(argv[i], fits[f]) == 0){
+                    config.fit = f;
                 }
             }
-        }
-        if (location != -1 && process[location].flag == 1){																	//If process is in memory
-            process[location].flag = 2; 																					//Mark task as completed
-            memBlocks[process[location].blockLoc] += process[location].size; 									            //Update the block
-            process[location].start = newReceivedTime;																		//Set the start time
-                process[location].finish = process[location].start + process[location].duration;							//Set the finish time
-            process[location].turnAround = process[location].finish - process[location].received;							//Calculate the turn around time
-            process[location].relative = (double)process[location].turnAround / process[location].duration;				    //Calculate the relative turn around time
-            newReceivedTime = process[location].finish;																		//Update the new received time variable
-        }
-        for (int i = 0; i < n; i++){																						//Checking if all tasks have been processed
-            if (process[i].flag == 1 && location != -1){
-                memNotEmpty = true;
+            if (config.fit == -1){
+                cout << "Placement must be first, next, best or worst" << endl;
+                return 1;
             }
         }
-    }
-    for (int i = 0; i < n; i++){																							//Find the total turn around time and the total relative turn around time
-        srtResults.ttat += process[i].turnAround;
-        srtResults.rtat += process[i].relative;
-    }
-    srtResults.ttat /= n;																					                //Calculate turn around time and relative turn around time
-    srtResults.rtat /= n;
-
-    srtTA += srtResults.ttat;
-    srtRTA += srtResults.rtat;
-}
-
-
-/***************************************************************************
-* void rrq1(int memBlocks[], int m, struct taskInfo process[])
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: Tasks from the taskInfo stream are processed using the memory
-               partitioning algorithm and stored into memory. Then scheduling is
-               performed on the tasks using the rrq1 algorithm. Finally, the avg
-               turnaround time and average relative turn around time is determined
-               for all tasks.
-
-* Parameters:
-* memBlocks[]   I/P int - Array representing the memory blocks
-* m             I/P int - The amount of blocks in memory
-* process[]     I/P struct taskInfo - The array of processes filled with random values
-***************************************************************************/
-
-void rrq1(int memBlocks[], int m, struct taskInfo process[]){
-    int rrFinish = 0, rrStart = 0;
-    location = 0;
-    int newReceivedTime = 0;
-    bool processed, completed = false;
-    int max, allocatedProcesses = 0, burstProcess = 0, n = numTasks;														//Holds the value of max received time
-    while (!completed){																							            //Keep going until all tasks have been processed
-        for (int i = 0; i < n; i++){ 																						//For all processes, perform the first fit algorithm
-            completed = true;
-            processed = false;
-            if (process[i].flag == -1){																						//Only process tasks with a flag of -1
-                for (int j = 0; j < m; j++){ 																				//For all the blocks in memory
-                    if (memBlocks[j] >= process[i].size){ 															        //Check if allocation is possible
-                        process[i].flag = 1;																				//Set task as being processed
-                        process[i].received = newReceivedTime;																//Set the process received time
-                        memBlocks[j] -= process[i].size;																    //lower block size
-                        process[i].blockLoc = j;																		    //Update block location in the struct
-                        processed = true;
-                        allocatedProcesses++;																				//Increment allocated tasks
-                        break;
-                    }
-                }
-                if (!processed){																					        //If the process was unable to be allocated
-                    max = -2147483640;
-                    if (burstProcess == allocatedProcesses){																//Ensures quantum is 1
-                        for (int j = 0; j < n; j++){
-                            if (process[j].flag == 1){																		//If process is in memory set to 0
-                                process[j].ignore = 0;
-                            }
-                        }
-                        burstProcess = 0;
-                    }
-                    rrStart++;
-                    rrFinish++;																								//Variable used to calculate the rrq1 finish time
-                    for (int l = n-1; l >= 0; l--)																			//Finds the process with the max received time in memory with ignore flag of 0
-                    {
-                        if (process[l].flag == 1 && process[l].ignore != 1){
-                            if (process[l].received > max)
-                            {
-                                max = process[l].received;
-                                location = l;
-                            }
-                        }
-                    }
-                    if (process[location].quantumStarted == 0){
-                        process[location].start = rrStart;
-                        process[location].quantumStarted = 1;
-                    }
-                    burstProcess++;																							//Increment burstProcess
-                    process[location].ignore = 1;																			//Change the ignore flag to 1
-                    if (burstProcess == allocatedProcesses){																//Used to control quantum = 1 logic
-                        for (int j = 0; j < n; j++){
-                            if (process[j].flag == 1){
-                                process[j].ignore = 0;
-                            }
-                        }
-                        burstProcess = 0;
-                    }
-                    process[location].spent++;																			    //Increment time spent
-                    if((process[location].spent - process[location].duration) == 0){ 								        //If time spent equals 0
-                        process[location].flag = 2; 																		//Set as completed
-                        memBlocks[process[location].blockLoc] += process[location].size; 						            //Update the block
-                        allocatedProcesses--; 																				//Decrement allocated tasks
-                        process[location].finish = rrFinish;																//Set the finish time
-                        process[location].turnAround = process[location].finish - process[location].received;				//Calculate the turn around time
-                        process[location].relative = (double)process[location].turnAround / process[location].duration;	    //Calculate the relative turn around time
-                        newReceivedTime = process[location].finish;															//Update the new received time variable
-                    }
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc){
+            const char *models[] = {"blocks", "holes", "buddy"};
+            i++;
+            config.model = -1;
+            for (int a = FIXED_BLOCKS; a <= BUDDY_SYSTEM; a++){
+                if (strcmp(argv[i], models[a]) == 0){
+                    config.model = a;
                 }
             }
-            for (int j = 0; j < n; j++){																					//Checking if all tasks have been processed
-                if (process[j].flag == -1){																					//Continue until all tasks are finished executing
-                    completed = false;
-                }
+            if (config.model == -1){
+                cout << "Memory model must be blocks, holes or buddy" << endl;
+                return 1;
             }
         }
-    }
-    bool memNotEmpty = true;
-    while (memNotEmpty){																							        //Process all remaining tasks in memory
-        max = -2147483640;
-        location = -1;
-        memNotEmpty = false;
-        if (burstProcess == allocatedProcesses){																			//Ensure quantum is 1
-            for (int i = 0; i < n; i++){
-                if (process[i].flag == 1){
-                    process[i].ignore = 0;
-                }
-            }
-            burstProcess = 0;
-        }
-        rrFinish++;																											//Variable used to calculate the rrq1 finish time
-        rrStart++;
-        for (int l = n-1; l >= 0; l--)																						//Finds the process in memory with the smallest received time and flag = 0
-        {
-            if (process[l].flag == 1 && process[l].ignore != 1){
-                if (process[l].received > max)
-                {
-                    max = process[l].received;
-                    location = l;
-                }
+        else if (strcmp(argv[i], "-z") == 0 && i + 1 < argc){
+            config.compactCost = atoi(argv[++i]);
+            if (config.compactCost < 0){
+                cout << "Compaction cost cannot be negative" << endl;
+                return 1;
             }
         }
-        if (process[location].quantumStarted == 0){
-            process[location].start = rrStart;
-            process[location].quantumStarted = 1;
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
         }
-        burstProcess++;																										//Increment burstProcess
-        process[location].ignore = 1;																						//Set ignore flag to 1
-        if (burstProcess == allocatedProcesses){
-            for (int i = 0; i < n; i++){
-                if (process[i].flag == 1){
-                    process[i].ignore = 0;
-                }
-            }
-            burstProcess = 0;
-        }
-        process[location].spent++;																						    //Increment time spent
-        if ((location != -1 && process[location].flag == 1) && ((process[location].spent - process[location].duration) == 0)){
-            process[location].flag = 2; 																					//Mark task as completed
-            memBlocks[process[location].blockLoc] += process[location].size; 									            //Update the block
-            allocatedProcesses--; 																							//Decrement allocated tasks
-            process[location].finish = rrFinish;																			//Set the finish time
-            process[location].turnAround = process[location].finish - process[location].received;							//Calculate the turn around time and relative turn around time
-            process[location].relative = (double)process[location].turnAround / process[location].duration;
-        }
-        for (int i = 0; i < n; i++){																						//Checking if all tasks have been processed
-            if (process[i].flag == 1 && location != -1){
-                memNotEmpty = true;
-            }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            numTasks = strtoll(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc){
+            config.window = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc){
+            tracePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc){
+            meanWidth = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc){
+            diffWidth = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc){
+            maxLoops = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc){
+            statsPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc){
+            checkPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc){
+            every = atoi(argv[++i]);
         }
     }
-    for (int i = 0; i < n; i++){																							//Find the total turn around time and the total relative turn around time
-        rrResults.ttat += process[i].turnAround;
-        rrResults.rtat += process[i].relative;
+    if (config.quantum < 1){
+        cout << "Quantum must be at least 1" << endl;
+        return 1;
     }
-    rrResults.ttat /= n;																						            //Calculate turn around time and relative turn around time
-    rrResults.rtat /= n;
-
-    rrTA += rrResults.ttat;
-    rrRTA += rrResults.rtat;
-}
-
-
-
-/***************************************************************************
-* void spn(int memBlocks[], int m, struct taskInfo process[])
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: Tasks from the taskInfo stream are processed using the memory
-               partitioning algorithm and stored into memory. Then scheduling is
-               performed on the tasks using the spn algorithm. Finally, the avg
-               turnaround time and average relative turn around time is determined
-               for all tasks.
-
-* Parameters:
-* memBlocks[]   I/P int - Array representing the memory blocks
-* m             I/P int - The amount of blocks in memory
-* process[]     I/P struct taskInfo - The array of processes filled with random values
-***************************************************************************/
-
-void spn(int memBlocks[], int m, struct taskInfo process[]){
-    location = 0;
-    int newReceivedTime = 0, n = numTasks;
-    bool processed, completed = false;
-    while (!completed){																							            //Keep going until all tasks have been processed
-
-        for (int i = 0; i < n; i++){ 																						//For all processes, perform the first fit algorithm
-            completed = true;
-            processed = false;
-
-            if (process[i].flag == -1){																						//Only process if the task's flag is -1
-                for (int j = 0; j < m; j++){ 																				//For all the blocks in memory
-                    if (memBlocks[j] >= process[i].size){ 															        //If allocation is possible
-                        process[i].flag = 1;																				//Change the process flag to 1 (representing allocated)
-                        process[i].received = newReceivedTime;																//Set the process received time
-                        memBlocks[j] -= process[i].size;																    //Reduce  block size
-                        process[i].blockLoc = j;																		    //Update block location in the struct
-                        processed = true;
-                        break;
-                    }
-                }
-                int min = 2147483640;
-                if (!processed){																					        //If the process was unable to be allocated
-                    for (int l = 0; l < n; l++)																				//Finds the process in memory with shortest time
-                    {
-                        if (process[l].flag == 1){
-                            if (process[l].duration < min)
-                            {
-                                min = process[l].duration;
-                                location = l;
-                            }
-                        }
-                    }
-                    process[location].flag = 2; 																			//Mark task as completed
-                    memBlocks[process[location].blockLoc] += process[location].size; 							            //Update the block
-                    process[location].start = newReceivedTime;																//Set the start time
-                    process[location].finish = process[location].start + process[location].duration;					    //Set the finish time
-                    process[location].turnAround = process[location].finish - process[location].received;					//Calculate the turn around time
-                    process[location].relative = (double)process[location].turnAround / process[location].duration;		    //Calculate the relative turn around time
-                    newReceivedTime = process[location].finish;																//Update the new received time
-                }
-            }
-            for (int j = 0; j < n; j++){																					//Checking if all tasks have been processed
-                if (process[j].flag == -1){																					//Loop till all tasks are processed
-                    completed = false;
-                }
-            }
+    if (meanWidth < 0 || diffWidth < 0 || maxLoops < 10){
+        cout << "Interval widths cannot be negative and at least 10 experiments are needed" << endl;
+        return 1;
+    }
+    if (config.blocks.empty()){																								// Make memory blocks of size 16, 16, 16, and 8 to equal free memory of 56
+        config.blocks = {16, 16, 16, 8};
+    }
+    long long largest = *max_element(config.blocks.begin(), config.blocks.end());											//Largest task an empty memory holds
+    if (config.model != FIXED_BLOCKS){																						//Holes and buddies make one memory of the whole layout
+        long long total = 0;
+        for (int b : config.blocks){
+            total += b;
         }
+        if (total > MAX_ADDRESSES){
+            cout << "Memory of the holes and buddy models is at most " << MAX_ADDRESSES << " units" << endl;
+            return 1;
+        }
+        largest = total;
+        if (config.model == BUDDY_SYSTEM)																					//Largest aligned power of two below the total
+            largest = 1LL << (63 - __builtin_clzll(largest));
     }
-    bool memNotEmpty = true;
-    while (memNotEmpty){																							        //Process all tasks left in memory
-        int min = 2147483640;
-        location = -1;
-        memNotEmpty = false;
-        for (int l = 0; l < n; l++)																							//Find the process in memory with the shortest service time
-        {
-            if (process[l].flag == 1){
-                if (process[l].duration < min)
-                {
-                    min = process[l].duration;
-                    location = l;
-                }
-            }
+    if (config.compactCost >= 0 && config.model != FREE_LIST){
+        cout << "Compaction needs the holes model, -a holes" << endl;
+        return 1;
+    }
+    struct traceFile trace;
+    if (tracePath){																											//Replay the trace once instead of generating experiments
+        if (!openTrace(tracePath, trace)){
+            cout << "Cannot read trace " << tracePath << endl;
+            return 1;
         }
-        if (location != -1 && process[location].flag == 1){																	//If process is in memory
-            process[location].flag = 2; 																					//Mark task as completed
-            memBlocks[process[location].blockLoc] += process[location].size; 									            //Update the block
-            process[location].start = newReceivedTime;																		//Set the start time
-            process[location].finish = process[location].start + process[location].duration;							    //Set the finish time
-            process[location].turnAround = process[location].finish - process[location].received;							//Calculate the turn around time
-            process[location].relative = (double)process[location].turnAround / process[location].duration;				    //Calculate the relative turn around time
-            newReceivedTime = process[location].finish;																		//Update the new received time variable
-        }
-        for (int i = 0; i < n; i++){																						//Checking if all tasks have been processed
-            if (process[i].flag == 1 && location != -1){
-                memNotEmpty = true;
-            }
+        if (trace.header->maxSize > UINT16_MAX){																			//Sizes are kept in 16 bits like the generated ones
+            cout << "Trace task sizes must fit in 16 bits" << endl;
+            return 1;
         }
+        if (trace.header->maxDuration > UINT16_MAX){
+            cout << "Trace service times must fit in 16 bits" << endl;
+            return 1;
+        }
+        if (trace.header->maxSize > largest){																				//Every task has to fit into an empty block
+            cout << "Largest memory block must hold the largest task of the trace, size " << trace.header->maxSize << endl;
+            return 1;
+        }
+        numTasks = trace.header->count;
+        loops = 1;
+        config.trace = &trace;
+    }
+    else if (largest < 16){																									//Every task has to fit into an empty block
+        cout << "Largest memory block must hold a task of size 16" << endl;
+        return 1;
     }
-    for (int i = 0; i < n; i++){																							//Find the total turn around time and the total relative turn around time
-        spnResults.ttat += process[i].turnAround;
-        spnResults.rtat += process[i].relative;
+    if (numTasks < 1 || config.window < 0){
+        cout << "Task count must be at least 1 and the window cannot be negative" << endl;
+        return 1;
+    }
+    if (config.window == 0 && !config.trace && numTasks > INT_MAX){															//Task indices are ints when the stream is generated up front
+        cout << "Task streams this long need streaming mode, use -w <window>" << endl;
+        return 1;
+    }
+    config.tasks = numTasks;
+    if (checkPath && (tracePath || outPath || every < 1)){																	//A resumed run could not add to these where the last one stopped
+        cout << "Checkpoints need at least 1 experiment between them and cannot be used with -r or -o" << endl;
+        return 1;
     }
-    spnResults.ttat /= n;																					                //Calculate turn around time and relative turn around time
-    spnResults.rtat /= n;
 
-    spnTA += spnResults.ttat;
-    spnRTA += spnResults.rtat;
-}
+    static struct runTotals totals;																							//Static, the sketches are too big for the stack
+    uint64_t setup = 14695981039346656037ULL;																				//Hash of everything the results depend on
+    long long settings[] = {(long long)seed, config.tasks, config.quantum, config.fit, config.window, config.loops, config.ulimit,
+                            loops, maxLoops, checkPath ? every : 0, POLICIES};
+    setup = hashBytes(setup, settings, sizeof(settings));
+    setup = hashBytes(setup, &meanWidth, sizeof(meanWidth));
+    setup = hashBytes(setup, &diffWidth, sizeof(diffWidth));
+    setup = hashBytes(setup, config.blocks.data(), config.blocks.size() * sizeof(int));
+    if (config.model != FIXED_BLOCKS){																						//Left out for fixed blocks, so their checkpoints stay valid
+        long long memory[] = {config.model, config.compactCost};
+        setup = hashBytes(setup, memory, sizeof(memory));
+    }
+    if (checkPath){
+        int loaded = loadCheckpoint(checkPath, setup, totals);
+        if (loaded == -1){
+            cout << "Checkpoint " << checkPath << " is not from a run with these settings" << endl;
+            return 1;
+        }
+        if (loaded == 1){
+            cout << "Resuming after " << totals.done << " experiments" << endl;
+        }
+    }
 
-/***************************************************************************
-* void fcfs(int memBlocks[], int m, struct taskInfo process[])
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: Tasks from the taskInfo stream are processed using the memory
-               partitioning algorithm and stored into memory. Then scheduling is
-               performed on the tasks using the fcfs algorithm. Finally, the avg
-               turnaround time and average relative turn around time is determined
-               for all tasks.
+    struct taskSink sink;
+    if (outPath){
+        if (!openSink(outPath, sink)){
+            cout << "Cannot write " << outPath << endl;
+            return 1;
+        }
+        config.sink = &sink;
+    }
 
-* Parameters:
-* memBlocks[]   I/P int - Array representing the memory blocks
-* m             I/P int - The amount of blocks in memory
-* process[]     I/P struct taskInfo - The array of processes filled with random values
-***************************************************************************/
+    if (statsPath){
+#ifdef SIM_STATS
+        if (totals.done > 0 && !trimStats(statsPath, totals.done)){															//Drop the lines of the round the last run did not finish
+            cout << "Cannot trim " << statsPath << endl;
+            return 1;
+        }
+        config.stats = fopen(statsPath, totals.done > 0 ? "a" : "w");														//A resumed run adds to the lines of the last one
+        if (config.stats == NULL){
+            cout << "Cannot write " << statsPath << endl;
+            return 1;
+        }
+#else
+        cout << "Counters need a build with -DSIM_STATS" << endl;
+        return 1;
+#endif
+    }
 
-void fcfs(int memBlocks[], int m, struct taskInfo process[]){
-    location = 0;
-    int newReceivedTime = 0, n = numTasks;
-    bool processed, completed = false;
-    while (!completed){																							            //Keep going until all tasks have been processed
-        for (int i = 0; i < n; i++){ 																						//For all processes, perform the first fit algorithm
-            completed = true;
-            processed = false;
-            if (process[i].flag == -1){																						//Only process if the task's flag is -1
-                for (int j = 0; j < m; j++){ 																				//For all the blocks in memory
-                    if (memBlocks[j] >= process[i].size){ 															        //If allocation is possible
-                        process[i].flag = 1;																				//Change the process flag to 1 (representing allocated)
-                        process[i].received = newReceivedTime;																//Set the process received time
-                        memBlocks[j] -= process[i].size;																    //Reduce  block size
-                        process[i].blockLoc = j;																		    //Update block location in the struct
-                        processed = true;
-                        break;
-                    }
-                }
-                int min = 2147483640;
-                if (!processed){																					        //If the process was unable to be allocated
-                    for (int l = 0; l < n; l++)																				//Finds the process in memory the smallest received time
-                    {
-                        if (process[l].flag == 1){
-                            if (process[l].received < min)
-                            {
-                                min = process[l].received;
-                                location = l;
-                            }
-                        }
-                    }
-                    process[location].flag = 2; 																			//Mark task as completed
-                    memBlocks[process[location].blockLoc] += process[location].size; 							            //Update the block
-                    process[location].start = newReceivedTime;																//Set the start time
-                    process[location].finish = process[location].start + process[location].duration;
-                    process[location].turnAround = process[location].finish - process[location].received;
-                    process[location].relative = (double)process[location].turnAround / process[location].duration;
-                    newReceivedTime = process[location].finish;
-                }
-            }
-            for (int j = 0; j < n; j++){																					//Checking if all tasks have been processed
-                if (process[j].flag == -1){																					//If everything has not been processed, ensure the loop keeps executing
-                    completed = false;
-                }
+    if (threads < 1)
+        threads = 1;
+    vector<struct runArena> arenas(threads);																				//Buffers reused by each worker
+    bool streaming = config.window > 0 || config.trace;
+    bool adaptive = (meanWidth > 0 || diffWidth > 0) && !config.trace;														//Run experiments until the intervals are narrow enough
+    cout << endl << "**Processing**" << endl << endl;
+    auto finished = [&](){																									//Ran every experiment, or in adaptive mode the intervals are narrow enough
+        if (!adaptive)
+            return totals.done >= loops;
+        if (totals.done < 10)
+            return false;
+        if (totals.done >= maxLoops)
+            return true;
+        bool narrow = true;
+        for (int p = 0; p < POLICIES; p++){
+            if (meanWidth > 0 && 2 * ciHalfWidth(totals.means[p]) > meanWidth)
+                narrow = false;
+            for (int o = p + 1; o < POLICIES; o++){
+                if (diffWidth > 0 && 2 * ciHalfWidth(totals.diffs[p][o]) > diffWidth)
+                    narrow = false;
             }
         }
+        return narrow;
+    };
+    auto nextRound = [&](int done){																							//End of the round that starts at done
+        return adaptive ? min(maxLoops, done + max(10, done / 4)) : loops;
+    };
+    int end = 0;																											//End of the round under way, a run that stopped between checkpoints picks up inside one
+    while (end < totals.done){
+        end = nextRound(end);
     }
-    bool memNotEmpty = true;
-    while (memNotEmpty){																							        //Process all tasks left in memory
-        int min = 2147483640;
-        location = -1;
-        memNotEmpty = false;
-        for (int l = 0; l < n; l++)																							//Find the process in memory with the smallest received time
-        {
-            if (process[l].flag == 1){
-                if (process[l].received < min)
-                {
-                    min = process[l].received;
-                    location = l;
+    while (totals.done < end || !finished()){																				//Run experiments in rounds, growing by a quarter so the intervals are not checked too often
+        int done = totals.done;
+        if (done >= end)
+            end = nextRound(done);
+        int round = end - done;
+        if (checkPath && round > every)																						//Split the round between checkpoints, the intervals are still only checked at its end
+            round = every;
+        vector<struct results> slots(round * POLICIES);																		//One result slot per experiment and policy
+        vector<struct workload> works(streaming ? 0 : round);																//Task stream of each experiment, unused when streaming
+        vector<struct workBatch> batches((round + BATCH_LANES - 1) / BATCH_LANES);
+        for (int b = 0; b < (int)batches.size(); b++){
+            batches[b].first = done + b * BATCH_LANES;
+            batches[b].lanes = min(BATCH_LANES, round - b * BATCH_LANES);
+            batches[b].works = streaming ? NULL : &works[b * BATCH_LANES];
+            batches[b].res = &slots[b * BATCH_LANES * POLICIES];
+        }
+        runPipeline(batches, threads, seed, config, arenas, [&](struct workBatch &batch){									//Sum in experiment order
+            for (int l = 0; l < batch.lanes; l++){
+                struct results *res = &batch.res[l * POLICIES];
+                for (int p = 0; p < POLICIES; p++){
+                    totals.ta[p] += res[p].ttat;
+                    totals.rta[p] += res[p].rtat;
+                    addSample(totals.means[p], res[p].ttat);
+                    for (int o = p + 1; o < POLICIES; o++){																	//Same task stream for every policy, so the pair's noise mostly cancels
+                        addSample(totals.diffs[p][o], res[o].ttat - res[p].ttat);
+                    }
                 }
             }
-        }
-        if (location != -1 && process[location].flag == 1){																	//If process is in memory
-            process[location].flag = 2; 																					//Mark task as completed
-            memBlocks[process[location].blockLoc] += process[location].size; 									            //Update the block
-            process[location].start = newReceivedTime;																		//Set the start time
-            process[location].finish = process[location].start + process[location].duration;							    //Set the finish time
-            process[location].turnAround = process[location].finish - process[location].received;							//Calculate the turn around time
-            process[location].relative = (double)process[location].turnAround / process[location].duration;				    //Calculate the relative turn around time
-            newReceivedTime = process[location].finish;																		//Update the new received time variable
-        }
-        for (int i = 0; i < n; i++){																						//Checking if all tasks have been processed
-            if (process[i].flag == 1 && location != -1){
-                memNotEmpty = true;
+        });
+        for (struct runArena &arena : arenas){																				//Move the sketches of the round into the totals
+            for (int p = 0; p < POLICIES; p++){
+                mergeHistogram(totals.tails[p].turnAround, arena.sketch[p].turnAround);
+                mergeHistogram(totals.tails[p].relative, arena.sketch[p].relative);
+                arena.sketch[p] = latencySketch();
             }
         }
+        totals.done += round;
+        if (config.stats)																									//Counters of the experiments the checkpoint holds are in the file before it does
+            fflush(config.stats);
+        if (checkPath && !saveCheckpoint(checkPath, setup, totals)){
+            cout << "Cannot write checkpoint " << checkPath << endl;
+            return 1;
+        }
     }
-    for (int i = 0; i < n; i++){																							//Find the total turn around time and the total relative turn around time
-        fcfsResults.ttat += process[i].turnAround;
-        fcfsResults.rtat += process[i].relative;
+    loops = totals.done;
+    closeTrace(trace);
+    for (struct runArena &arena : arenas){																					//Write out the rows still buffered
+        flushColumns(arena.out);
+    }
+    if (!closeSink(sink)){
+        cout << "Writing " << outPath << " failed" << endl;
+    }
+    if (config.stats && fclose(config.stats) != 0){
+        cout << "Writing " << statsPath << " failed" << endl;
     }
-    fcfsResults.ttat /= n;																					                //Calculate turn around time and relative turn around time
-    fcfsResults.rtat /= n;
-
-    fcfsTA += fcfsResults.ttat;
-    fcfsRTA += fcfsResults.rtat;
-}
-/***************************************************************************
-* int main( int argc, char *argv[] )
-* Author: Venkata Bapanapalli
-* Date: 3 May 2020
-* Description: Initializes the task stream by calling the setTasks() function
-			   and call the four process scheduling algorithms a thousand times
-			   in order to generate results regarding the average turnaround time
-			   and the average relative turnaround time.
-			   The results regarding these calculations are displayed at the end.
-* Parameters:
-* argc I/P int The number of arguments on the command line
-* argv I/P char *[] The arguments on the command line
-* main O/P int Status code (not currently used)
-**************************************************************************/
-int main(int argc, char *argv[])
-{
-    int fcfsBlock[5];																										//Represents memory used for FCFS sequence
-    int spnBlock[5];																										//Represents memory used for SPN sequence
-    int rrBlock[5];																											//Represents memory used for RR sequence
-    int srtBlock[5];																										//Represents memory used for SRT sequence
-    int m = 4;																												//Number of blocks in memory
-    int loops = 50;
 
-    struct taskInfo fcfsTasks[numTasks];																					//Creating an array of task structures
-    struct taskInfo spnTasks[numTasks];
-    struct taskInfo rrTasks[numTasks];
-    struct taskInfo srtTasks[numTasks];
-    cout << endl << "**Processing**" << endl << endl;
-    for (int i = 0; i < loops; i++){																					    //Process all tasks for given loops
+    cout << "Average turn around time for FCFS is " << setprecision(5) << (totals.ta[FCFS_POLICY]/loops) << endl;			//Printing results
+    cout << "Average relative turn around time for FCFS is " << setprecision(5) << (totals.rta[FCFS_POLICY]/loops) << endl;
 
-        setTasks(fcfsTasks, fcfsBlock);																			            //Randomizing all tasks
-        setTasks(spnTasks, spnBlock);
-        setTasks(rrTasks, rrBlock);
-        setTasks(srtTasks, srtBlock);
+    cout << "Average turn around time for RRq" << config.quantum << " is " << setprecision(5) << (totals.ta[RR_POLICY]/loops) << endl;
+    cout << "Average relative turn around time for RRq" << config.quantum << " is " << setprecision(4) << (totals.rta[RR_POLICY]/loops) << endl;
 
-        for (int j = 0; j < numTasks; j++){
+    cout << "Average turn around time for SPN is " << setprecision(5) << (totals.ta[SPN_POLICY]/loops) << endl;
+    cout << "Average relative turn around time for SPN is " << setprecision(4) << (totals.rta[SPN_POLICY]/loops) << endl;
 
-            srtTasks[j].size = spnTasks[j].size;
-            srtTasks[j].duration = spnTasks[j].duration;
+    cout << "Average turn around time for SRT is " << setprecision(5) << (totals.ta[SRT_POLICY]/loops) << endl;
+    cout << "Average relative turn around time for SRT is " << setprecision(4) << (totals.rta[SRT_POLICY]/loops) << endl;
 
-            rrTasks[j].size = spnTasks[j].size;
-            rrTasks[j].duration = spnTasks[j].duration;
+    cout << "Average turn around time for HRRN is " << setprecision(5) << (totals.ta[HRRN_POLICY]/loops) << endl;
+    cout << "Average relative turn around time for HRRN is " << setprecision(4) << (totals.rta[HRRN_POLICY]/loops) << endl;
 
-            fcfsTasks[j].size = spnTasks[j].size;
-            fcfsTasks[j].duration = spnTasks[j].duration;
+    cout << "Average turn around time for MLFQq" << config.quantum << " is " << setprecision(5) << (totals.ta[MLFQ_POLICY]/loops) << endl;
+    cout << "Average relative turn around time for MLFQq" << config.quantum << " is " << setprecision(4) << (totals.rta[MLFQ_POLICY]/loops) << endl;
 
+    const string names[POLICIES] = {"FCFS", "RRq" + to_string(config.quantum), "SPN", "SRT", "HRRN", "MLFQq" + to_string(config.quantum)};
+    if (loops > 1){																											//Printing confidence intervals
+        cout << endl << "95% confidence intervals over " << loops << " experiments" << endl;
+        for (int p = 0; p < POLICIES; p++){
+            cout << "Average turn around time for " << names[p] << " is " << setprecision(5) << totals.means[p].mean
+                 << " +/- " << setprecision(3) << ciHalfWidth(totals.means[p]) << endl;
+        }
+        for (int p = 0; p < POLICIES; p++){
+            for (int o = p + 1; o < POLICIES; o++){
+                cout << "Paired difference " << names[o] << " - " << names[p] << " is " << setprecision(4) << totals.diffs[p][o].mean
+                     << " +/- " << setprecision(3) << ciHalfWidth(totals.diffs[p][o]);
+                double paired = variance(totals.diffs[p][o]);
+                if (paired > 0){																							//Runs independent streams would need for the same interval
+                    cout << ", " << setprecision(3) << (variance(totals.means[p]) + variance(totals.means[o])) / paired << "x fewer runs than unpaired";
+                }
+                cout << endl;
+            }
         }
-        fcfs(fcfsBlock, m, fcfsTasks);																					    //Calling FCFS function
-        spn(spnBlock, m, spnTasks);																						    //Calling SPN function
-        rrq1(rrBlock, m, rrTasks);																						    //Calling RR function
-        srt(srtBlock, m, srtTasks);																						    //Calling SRT function
     }
 
-    cout << "Average turn around time for FCFS is " << setprecision(5) << (fcfsTA/loops) << endl;                       //Printing results
-    cout << "Average relative turn around time for FCFS is " << setprecision(5) << (fcfsRTA/loops) << endl;
-
-    cout << "Average turn around time for RRq1 is " << setprecision(5) << (rrTA/loops) << endl;
-    cout << "Average relative turn around time for RRq1 is " << setprecision(4) << (rrRTA/loops) << endl;
-
-    cout << "Average turn around time for SPN is " << setprecision(5) << (spnTA/loops) << endl;
-    cout << "Average relative turn around time for SPN is " << setprecision(4) << (spnRTA/loops) << endl;
-
-    cout << "Average turn around time for SRT is " << setprecision(5) << (srtTA/loops) << endl;
-    cout << "Average relative turn around time for SRT is " << setprecision(4) << (srtRTA/loops) << endl;
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    cout << endl;
+    for (int p = 0; p < POLICIES; p++){																						//Printing tails
+        cout << "Turn around time p50/p90/p99/p99.9/max for " << names[p] << " is ";
+        for (double q : quantiles){
+            cout << valueAtQuantile(totals.tails[p].turnAround, q) << "/";
+        }
+        cout << totals.tails[p].turnAround.max << endl;
+        cout << "Relative turn around time p50/p90/p99/p99.9/max for " << names[p] << " is " << setprecision(4);
+        for (double q : quantiles){
+            cout << (double)valueAtQuantile(totals.tails[p].relative, q) / RELATIVE_SCALE << "/";
+        }
+        cout << (double)totals.tails[p].relative.max / RELATIVE_SCALE << endl;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,2670 @@
+/***************************************************************************
+* File: simulator.cpp
+* Author: Venkata Bapanapalli
+* Description: Task streams, memory placement, the discrete-event engine, the
+               scheduling functions and the thread pool declared in simulator.h.
+               Shared by the simulator in main.cpp and the benchmarks in bench.cpp.
+***************************************************************************/
+#include "simulator.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+long long numTasks = 1000;
+struct columnPool spareColumns;																								//Columns handed from finished experiments to new ones
+
+/***************************************************************************
+* uint64_t splitMix(uint64_t &x)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Steps a splitmix64 generator. Only used to spread a seed out
+               over the xoshiro256** state.
+* Parameters:
+* x         I/P uint64_t - The splitmix64 state
+* splitMix  O/P uint64_t - The next splitmix64 output
+***************************************************************************/
+
+uint64_t splitMix(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/***************************************************************************
+* void seedStream(struct rngStream &rng, uint64_t seed, uint64_t stream)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Starts random number stream number stream of the given seed.
+               The state only depends on the seed and the stream number, so
+               experiment k gets the same numbers in any order on any thread.
+* Parameters:
+* rng       I/P struct rngStream - The stream to seed
+* seed      I/P uint64_t - The seed given on the command line
+* stream    I/P uint64_t - The stream number, the experiment number
+***************************************************************************/
+
+void seedStream(struct rngStream &rng, uint64_t seed, uint64_t stream)
+{
+    uint64_t x = seed;
+    x = splitMix(x) ^ stream;																								//Mix the seed first so nearby seeds do not share streams
+    for (int i = 0; i < 4; i++){
+        rng.s[i] = splitMix(x);
+    }
+}
+
+/***************************************************************************
+* uint64_t nextRandom(struct rngStream &rng)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Steps the xoshiro256** generator of a stream.
+* Parameters:
+* rng           I/P struct rngStream - The stream to draw from
+* nextRandom    O/P uint64_t - 64 random bits
+***************************************************************************/
+
+inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+inline uint64_t nextRandom(struct rngStream &rng)
+{
+    uint64_t *s = rng.s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/***************************************************************************
+* void uniform(struct rngStream &rng, int lo, int hi)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: generates uniform random integers of values from lo up to but
+               not including hi.
+* Parameters:
+* rng   I/P struct rngStream - The stream to draw from
+* lo    I/P int - min value to generate.
+* hi    I/P int - max value to generate.
+***************************************************************************/
+
+int uniform(struct rngStream &rng, int lo, int hi)
+{
+    uint32_t range = hi - lo;
+    uint64_t m = (nextRandom(rng) >> 32) * range;																			//Multiply and shift into the range
+    if ((uint32_t)m < range){																								//Reject the few values that would bias the low end
+        uint32_t threshold = -range % range;
+        while ((uint32_t)m < threshold){
+            m = (nextRandom(rng) >> 32) * range;
+        }
+    }
+    return (int)(m >> 32) + lo;
+}
+
+/***************************************************************************
+* int normal(struct rngStream &rng, int loops, int ulimit)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: generates normal random integers of values between lo and hi.
+* Parameters:
+* rng       I/P struct rngStream - The stream to draw from
+* loops     I/P int - number of loops to do for loop.
+* ulimit    I/P int - max  value to generate.
+***************************************************************************/
+
+int normal(struct rngStream &rng, int loops, int ulimit)
+{
+    int x = 0;
+    for(int i = 0; i < loops; i++)																							//Loops four times and generates a random number between 1-16
+    {
+        x += uniform(rng, 0, ulimit);
+    }
+    return x;
+}
+
+/***************************************************************************
+* int nextNormal(struct normalSource &src)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Draws the next normal random integer of a stream, the sum of loops
+               uniform values below ulimit. When ulimit is a power of two every
+               64 bit draw is cut into as many uniform values as it holds, so 4 by
+               4 sizes and durations cost one draw for every 8 values.
+* Parameters:
+* src           I/P struct normalSource - The stream to draw from
+* nextNormal    O/P int - The value drawn
+***************************************************************************/
+
+inline int nextNormal(struct normalSource &src)
+{
+    if (src.ulimit <= 0 || (src.ulimit & (src.ulimit - 1)) != 0){															//Not a power of two, draw one at a time
+        return normal(src.rng, src.loops, src.ulimit);
+    }
+    int bits = __builtin_ctz(src.ulimit);
+    int x = 0;
+    for (int j = 0; j < src.loops; j++){
+        if (src.left == 0){
+            src.word = nextRandom(src.rng);
+            src.left = bits ? 64 / bits : 1;
+        }
+        x += src.word & (src.ulimit - 1);
+        src.word >>= bits;
+        src.left--;
+    }
+    return x;
+}
+
+/***************************************************************************
+* void drawTask(struct normalSource &src, uint16_t &size, uint16_t &duration)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Draws the size and duration of the next task in a task stream. A
+               size or duration less than 1 is set to 1.
+* Parameters:
+* src       I/P struct normalSource - The stream to draw from
+* size      O/P uint16_t - Task size
+* duration  O/P uint16_t - Task duration
+***************************************************************************/
+
+inline void drawTask(struct normalSource &src, uint16_t &size, uint16_t &duration)
+{
+    size = nextNormal(src);
+    if( size < 1 )
+        size = 1;
+    duration = nextNormal(src);
+    if( duration < 1 )
+        duration = 1;
+}
+
+/***************************************************************************
+* void takeColumn(vector<uint16_t> &column)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives an empty column a buffer left over by a finished experiment
+               if there is one, so new task streams do not allocate.
+* Parameters:
+* column    O/P vector<uint16_t> - The column to fill
+***************************************************************************/
+
+void takeColumn(vector<uint16_t> &column)
+{
+    lock_guard<mutex> guard(spareColumns.lock);
+    if (!spareColumns.spare.empty()){
+        column.swap(spareColumns.spare.back());
+        spareColumns.spare.pop_back();
+    }
+}
+
+/***************************************************************************
+* void giveColumn(vector<uint16_t> &column)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Hands the buffer of a column that is no longer needed to the
+               spare columns. The column is left empty.
+* Parameters:
+* column    I/P vector<uint16_t> - The column to give up
+***************************************************************************/
+
+void giveColumn(vector<uint16_t> &column)
+{
+    lock_guard<mutex> guard(spareColumns.lock);
+    spareColumns.spare.emplace_back();
+    spareColumns.spare.back().swap(column);
+}
+
+/***************************************************************************
+* void setTasks(struct workload &work, struct normalSource &src, long long count)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Initializes the task stream with random size and duration of a value
+               between 1-16.
+* Parameters:
+* work  I/P struct workload - The task stream to fill
+* src   I/P struct normalSource - The stream to draw sizes and durations from
+* count I/P long long - Tasks in the task stream
+***************************************************************************/
+
+void setTasks(struct workload &work, struct normalSource &src, long long count)
+{
+    takeColumn(work.size);
+    takeColumn(work.duration);
+    work.size.resize(count);
+    work.duration.resize(count);
+    for( long long j=0; j < count; j++)																						// Randomize the sizes and durations of 1000 tasks
+    {
+        drawTask(src, work.size[j], work.duration[j]);
+    }
+}
+
+/***************************************************************************
+* void setBlocks(struct memoryMap &mem, const vector<int> &blocks, int fit)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Creates the memory blocks for a run and builds the index over
+               their free space. A segment tree holds the most free space in
+               each range of blocks for first, next and worst fit, and best fit
+               keeps the blocks in a set ordered by free space. Buffers and set
+               nodes of the last run in the same memory are reused.
+* Parameters:
+* mem       I/P struct memoryMap - The memory to set up
+* blocks    I/P vector<int> - Size of each memory block
+* fit       I/P int - Placement algorithm used to pick a block
+***************************************************************************/
+
+void setBlocks(struct memoryMap &mem, const vector<int> &blocks, int fit)
+{
+    mem.model = FIXED_BLOCKS;
+    mem.m = blocks.size();
+    mem.fit = fit;
+    mem.nextBlock = 0;
+    mem.memBlocks = blocks;
+    mem.freeSpace = 0;
+    for (int b : blocks){
+        mem.freeSpace += b;
+    }
+    mem.leaves = 1;
+    while (mem.leaves < mem.m){
+        mem.leaves *= 2;
+    }
+    mem.tree.assign(2 * mem.leaves, -1);																					//Padding leaves never fit a task
+    for (int j = 0; j < mem.m; j++){
+        mem.tree[mem.leaves + j] = blocks[j];
+    }
+    for (int node = mem.leaves - 1; node >= 1; node--){
+        mem.tree[node] = max(mem.tree[2 * node], mem.tree[2 * node + 1]);
+    }
+    set<pair<int, int>> old;
+    old.swap(mem.bySize);
+    if (fit == BEST_FIT){
+        for (int j = 0; j < mem.m; j++){
+            if (old.empty()){
+                mem.bySize.insert({blocks[j], j});
+            }
+            else {																											//Reuse a node of the last run
+                set<pair<int, int>>::node_type node = old.extract(old.begin());
+                node.value() = {blocks[j], j};
+                mem.bySize.insert(move(node));
+            }
+        }
+    }
+}
+
+/***************************************************************************
+* int searchFit(const struct memoryMap &mem, int node, int nl, int nr, int lo, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Finds the first block at or after lo with at least size free,
+               searching the subtree of node which covers blocks nl to nr.
+* Parameters:
+* mem       I/P struct memoryMap - The memory to search
+* node      I/P int - The segment tree node
+* nl        I/P int - First block covered by the node
+* nr        I/P int - Last block covered by the node
+* lo        I/P int - First block that may be returned
+* size      I/P int - Free space needed
+* searchFit O/P int - The block found, -1 if none
+***************************************************************************/
+
+int searchFit(const struct memoryMap &mem, int node, int nl, int nr, int lo, int size)
+{
+    if (nr < lo || mem.tree[node] < size){																					//Nothing in this range can hold the task
+        return -1;
+    }
+    if (nl == nr){
+        return nl;
+    }
+    int mid = (nl + nr) / 2;
+    int j = searchFit(mem, 2 * node, nl, mid, lo, size);
+    if (j == -1){
+        j = searchFit(mem, 2 * node + 1, mid + 1, nr, lo, size);
+    }
+    return j;
+}
+
+/***************************************************************************
+* void setHoles(struct memoryMap &mem, int size, int fit)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sets up variable partitions, one hole over addresses 0 to
+               size-1. The segment tree gets a leaf per address holding the
+               length of the hole that starts there, so searchFit finds holes
+               as it finds blocks. A finished run has freed and merged every
+               task back into that one hole, so a memory of the same size is
+               taken as it is and only the set of best fit is redone.
+* Parameters:
+* mem       I/P struct memoryMap - The memory to set up
+* size      I/P int - Addresses in memory
+* fit       I/P int - Placement algorithm used to pick a hole
+***************************************************************************/
+
+void setHoles(struct memoryMap &mem, int size, int fit)
+{
+    bool whole = mem.model == FREE_LIST && mem.m == size && mem.freeSpace == size;											//Left as one hole by the last run
+    mem.model = FREE_LIST;
+    mem.fit = fit;
+    mem.nextBlock = 0;
+    mem.bySize.clear();
+    if (fit == BEST_FIT){
+        mem.bySize.insert({size, 0});
+    }
+    if (whole){
+        return;
+    }
+    mem.m = size;
+    mem.freeSpace = size;
+    mem.leaves = 1;
+    while (mem.leaves < size){
+        mem.leaves *= 2;
+    }
+    mem.tree.assign(2 * mem.leaves, -1);																					//Padding leaves never fit a task
+    fill(mem.tree.begin() + mem.leaves, mem.tree.begin() + mem.leaves + size, 0);
+    mem.tree[mem.leaves] = size;
+    for (int node = mem.leaves - 1; node >= 1; node--){
+        mem.tree[node] = max(mem.tree[2 * node], mem.tree[2 * node + 1]);
+    }
+    mem.holeLen.assign(size, 0);
+    mem.holeLen[0] = size;
+    mem.holeStart.assign(size, 0);
+    mem.owner.assign(size, -1);
+}
+
+/***************************************************************************
+* void takeHole(struct memoryMap &mem, int j, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Places a task at the start of the hole at address j. What is
+               left of the hole after the task stays a hole. O(log M).
+* Parameters:
+* mem       I/P struct memoryMap - The memory
+* j         I/P int - Start of the hole, as found by findBlock
+* size      I/P int - Size of the task, at most the hole's length
+***************************************************************************/
+
+void takeHole(struct memoryMap &mem, int j, int size)
+{
+    int len = mem.holeLen[j];
+    set<pair<int, int>>::node_type node;
+    if (mem.fit == BEST_FIT){
+        node = mem.bySize.extract({len, j});
+    }
+    mem.holeLen[j] = 0;
+    setLeaf(mem, j, 0);
+    mem.freeSpace -= size;
+    if (len > size){																										//The rest of the hole starts after the task
+        int rest = j + size;
+        mem.holeLen[rest] = len - size;
+        mem.holeStart[j + len - 1] = rest;
+        setLeaf(mem, rest, len - size);
+        if (node){																											//Reuse the node of the old hole
+            node.value() = {len - size, rest};
+            mem.bySize.insert(move(node));
+        }
+    }
+}
+
+/***************************************************************************
+* void giveHole(struct memoryMap &mem, int j, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Frees the task at address j, merging its space with the holes
+               right above and below it. The hole above starts where the task
+               ends, and the one below is found by the boundary tag at its last
+               address, so no search is needed. O(log M).
+* Parameters:
+* mem       I/P struct memoryMap - The memory
+* j         I/P int - Address of the task
+* size      I/P int - Size of the task
+***************************************************************************/
+
+void giveHole(struct memoryMap &mem, int j, int size)
+{
+    int start = j, len = size;
+    bool sized = mem.fit == BEST_FIT;
+    set<pair<int, int>>::node_type node;
+    mem.freeSpace += size;
+    int above = j + size;
+    if (above < mem.m && mem.holeLen[above] > 0){																			//Merge with the hole above
+        len += mem.holeLen[above];
+        if (sized)
+            node = mem.bySize.extract({mem.holeLen[above], above});
+        mem.holeLen[above] = 0;
+        setLeaf(mem, above, 0);
+    }
+    int below = j > 0 ? mem.holeStart[j - 1] : 0;
+    if (j > 0 && mem.holeLen[below] > 0 && below + mem.holeLen[below] == j){												//Merge with the hole below, the tag is stale unless that hole ends at j
+        start = below;
+        len += mem.holeLen[below];
+        if (sized)
+            node = mem.bySize.extract({mem.holeLen[below], below});
+    }
+    mem.holeLen[start] = len;
+    mem.holeStart[start + len - 1] = start;
+    setLeaf(mem, start, len);
+    if (sized && node){
+        node.value() = {len, start};
+        mem.bySize.insert(move(node));
+    }
+    else if (sized){
+        mem.bySize.insert({len, start});
+    }
+}
+
+/***************************************************************************
+* void setBuddies(struct memoryMap &mem, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sets up a buddy system over addresses 0 to size-1. The addresses
+               are rounded up to a power of two and split into the largest
+               aligned blocks that fit below size, one of each order at most,
+               and the blocks past size are never free. A finished run has
+               merged every block back into those, so a buddy system of the
+               same size is taken as it is.
+* Parameters:
+* mem       I/P struct memoryMap - The memory to set up
+* size      I/P int - Addresses in memory
+***************************************************************************/
+
+void setBuddies(struct memoryMap &mem, int size)
+{
+    bool whole = mem.model == BUDDY_SYSTEM && mem.m == size && mem.freeSpace == size;										//Left merged by the last run
+    mem.model = BUDDY_SYSTEM;
+    if (whole){
+        return;
+    }
+    mem.m = size;
+    mem.freeSpace = size;
+    mem.orders = buddyOrder(size);
+    int addresses = 1 << mem.orders;
+    mem.freeOrders = 0;
+    mem.freeHead.assign(mem.orders + 1, -1);
+    mem.nextFree.resize(addresses);
+    mem.prevFree.resize(addresses);
+    mem.freeOrder.assign(addresses, -1);
+    int j = 0;
+    for (int k = mem.orders; k >= 0; k--){																					//Largest blocks first, each is aligned to its size
+        if (j + (1 << k) <= size){
+            pushBuddy(mem, j, k);
+            j += 1 << k;
+        }
+    }
+}
+
+/***************************************************************************
+* void setMemory(struct memoryMap &mem, const struct simConfig &config)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sets up the memory model of a config for a run. Holes and
+               buddies get one memory as big as the blocks of the layout
+               together.
+* Parameters:
+* mem       I/P struct memoryMap - The memory to set up
+* config    I/P struct simConfig - Memory model, layout, placement algorithm and compaction cost
+***************************************************************************/
+
+void setMemory(struct memoryMap &mem, const struct simConfig &config)
+{
+    int size = 0;
+    for (int b : config.blocks){
+        size += b;
+    }
+    if (config.model == FREE_LIST)
+        setHoles(mem, size, config.fit);
+    else if (config.model == BUDDY_SYSTEM)
+        setBuddies(mem, size);
+    else
+        setBlocks(mem, config.blocks, config.fit);
+    mem.compactCost = config.compactCost;
+}
+
+/***************************************************************************
+* void pushBuddy(struct memoryMap &mem, int j, int k)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds the block of order k at address j to the front of its
+               order's free list.
+* Parameters:
+* mem       I/P struct memoryMap - The buddy system
+* j         I/P int - Address of the block
+* k         I/P int - Its order
+***************************************************************************/
+
+void pushBuddy(struct memoryMap &mem, int j, int k)
+{
+    int head = mem.freeHead[k];
+    mem.freeOrder[j] = k;
+    mem.prevFree[j] = -1;
+    mem.nextFree[j] = head;
+    if (head != -1)
+        mem.prevFree[head] = j;
+    mem.freeHead[k] = j;
+    mem.freeOrders |= 1ULL << k;
+}
+
+/***************************************************************************
+* void dropBuddy(struct memoryMap &mem, int j)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the free block at address j off its order's free list.
+* Parameters:
+* mem       I/P struct memoryMap - The buddy system
+* j         I/P int - Address of the block
+***************************************************************************/
+
+void dropBuddy(struct memoryMap &mem, int j)
+{
+    int k = mem.freeOrder[j];
+    int prev = mem.prevFree[j], next = mem.nextFree[j];
+    mem.freeOrder[j] = -1;
+    if (prev != -1)
+        mem.nextFree[prev] = next;
+    else
+        mem.freeHead[k] = next;
+    if (next != -1)
+        mem.prevFree[next] = prev;
+    if (mem.freeHead[k] == -1)
+        mem.freeOrders &= ~(1ULL << k);
+}
+
+/***************************************************************************
+* void takeBuddy(struct memoryMap &mem, int j, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Places a task in the free block at address j, halving the block
+               until the task's order and freeing the upper halves. O(log M).
+* Parameters:
+* mem       I/P struct memoryMap - The buddy system
+* j         I/P int - Address of the block, as found by findBuddy
+* size      I/P int - Size of the task
+***************************************************************************/
+
+void takeBuddy(struct memoryMap &mem, int j, int size)
+{
+    int k = mem.freeOrder[j];
+    int need = buddyOrder(size);
+    dropBuddy(mem, j);
+    while (k > need){																										//Split off the upper half
+        k--;
+        pushBuddy(mem, j + (1 << k), k);
+    }
+    mem.freeSpace -= 1 << need;
+}
+
+/***************************************************************************
+* void giveBuddy(struct memoryMap &mem, int j, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Frees the block of the task at address j and merges it with its
+               buddy, the block it was split from, for as long as the buddy is
+               free as a whole. O(log M).
+* Parameters:
+* mem       I/P struct memoryMap - The buddy system
+* j         I/P int - Address of the task
+* size      I/P int - Size of the task
+***************************************************************************/
+
+void giveBuddy(struct memoryMap &mem, int j, int size)
+{
+    int k = buddyOrder(size);
+    mem.freeSpace += 1 << k;
+    while (k < mem.orders){
+        int buddy = j ^ (1 << k);
+        if (mem.freeOrder[buddy] != k)																						//In use or split
+            break;
+        dropBuddy(mem, buddy);
+        j &= ~(1 << k);
+        k++;
+    }
+    pushBuddy(mem, j, k);
+}
+
+/***************************************************************************
+* bool parseBlocks(const char *list, vector<int> &blocks)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads a memory layout from the command line. The layout is a comma
+               separated list of block sizes where countxsize repeats a size,
+               so 16,16,16,8 and 3x16,8 are the same layout. Sizes have to fit
+               in an int and a layout has at most MAX_ADDRESSES blocks.
+* Parameters:
+* list          I/P const char * - The layout to read
+* blocks        O/P vector<int> - Size of each memory block
+* parseBlocks   O/P bool - False if the layout is not valid
+***************************************************************************/
+
+bool parseBlocks(const char *list, vector<int> &blocks)
+{
+    blocks.clear();
+    while (*list){
+        char *end;
+        long count = 1, size = strtol(list, &end, 10);
+        if (*end == 'x'){
+            count = size;
+            size = strtol(end + 1, &end, 10);
+        }
+        if (end == list || size < 1 || count < 1 || (*end != ',' && *end != '\0')){
+            return false;
+        }
+        if (size > INT_MAX || count > MAX_ADDRESSES - (long)blocks.size()){													//Would wrap in the int sizes or not fit in memory
+            return false;
+        }
+        blocks.insert(blocks.end(), count, size);
+        list = *end == ',' ? end + 1 : end;
+    }
+    return !blocks.empty();
+}
+
+/***************************************************************************
+* double variance(const struct welford &stats)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the sample variance of a running stats.
+* Parameters:
+* stats     I/P struct welford - The running stats
+* variance  O/P double - The variance, 0 with less than two samples
+***************************************************************************/
+
+double variance(const struct welford &stats)
+{
+    return stats.count > 1 ? stats.m2 / (stats.count - 1) : 0;
+}
+
+/***************************************************************************
+* double tCritical(long long df)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the two sided 95% critical value of Student's t with df
+               degrees of freedom, using the Cornish-Fisher expansion around
+               the normal value. Within 0.2% from 5 degrees of freedom up.
+* Parameters:
+* df        I/P long long - Degrees of freedom
+* tCritical O/P double - The critical value
+***************************************************************************/
+
+double tCritical(long long df)
+{
+    const double z = 1.959964;
+    if (df < 1)
+        return INFINITY;
+    double z3 = z * z * z, z5 = z3 * z * z;
+    return z + (z3 + z) / (4.0 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96.0 * df * df);
+}
+
+/***************************************************************************
+* double ciHalfWidth(const struct welford &stats)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the half width of the 95% confidence interval of the mean of
+               the samples in a running stats.
+* Parameters:
+* stats         I/P struct welford - The running stats
+* ciHalfWidth   O/P double - The half width, infinite with less than two samples
+***************************************************************************/
+
+double ciHalfWidth(const struct welford &stats)
+{
+    if (stats.count < 2)
+        return INFINITY;
+    return tCritical(stats.count - 1) * sqrt(variance(stats) / stats.count);
+}
+
+/***************************************************************************
+* void storeResults(const struct simEngine &sim, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Copies the avg and variance of the turn around time and relative
+               turn around time of a finished run into its result slot.
+* Parameters:
+* sim   I/P struct simEngine - The finished run
+* res   O/P struct results - Where the results are stored
+***************************************************************************/
+
+void storeResults(const struct simEngine &sim, struct results &res)
+{
+    res.ttat = sim.turnAround.mean;
+    res.rtat = sim.relative.mean;
+    res.ttatVar = variance(sim.turnAround);
+    res.rtatVar = variance(sim.relative);
+}
+
+/***************************************************************************
+* int newSlot(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Finds a slot to hold a task drawn while streaming. Slots of
+               finished tasks are reused, so the columns only grow with the
+               amount of tasks pending or in memory at once.
+* Parameters:
+* sim       I/P struct simEngine - The engine holding the run state
+* newSlot   O/P int - The slot
+***************************************************************************/
+
+int newSlot(struct simEngine &sim){
+    if (!sim.freeSlots.empty()){
+        int i = sim.freeSlots.back();
+        sim.freeSlots.pop_back();
+        return i;
+    }
+    struct taskState &process = *sim.process;
+    int i = sim.slotId.size();
+    sim.slotId.push_back(0);
+    sim.streamed.size.push_back(0);
+    sim.streamed.duration.push_back(0);
+    sim.nextPending.push_back(0);
+    process.flag.push_back(-1);
+    process.blockLoc.push_back(0);
+    process.spent.push_back(0);
+    process.received.push_back(0);
+    process.started.push_back(0);
+    sim.readyPos.push_back(-1);
+    sim.link.push_back(-1);
+    sim.level.push_back(0);
+    return i;
+}
+
+/***************************************************************************
+* void addPending(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the next task from the task stream and links it onto the
+               end of the pending list. When streaming the task is drawn now, or
+               read from the trace being replayed.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+***************************************************************************/
+
+void addPending(struct simEngine &sim){
+    int i;
+    if (sim.streaming){
+        i = newSlot(sim);
+        if (sim.trace){																										//Copy the task out of the mapped trace
+            sim.streamed.size[i] = sim.trace[sim.generated].size;
+            sim.streamed.duration[i] = sim.trace[sim.generated].duration;
+        }
+        else {
+            drawTask(*sim.gen, sim.streamed.size[i], sim.streamed.duration[i]);
+        }
+        sim.slotId[i] = sim.generated;
+        sim.process->flag[i] = -1;
+        sim.process->spent[i] = 0;
+    }
+    else {
+        i = sim.generated;
+    }
+    sim.generated++;
+    STAT(sim.stats.peakPending = max(sim.stats.peakPending, sim.pending + 1);)
+    if (sim.pending == 0){																									//Only task in the list
+        sim.nextPending[i] = i;
+        sim.prevPending = i;
+    }
+    else {
+        sim.nextPending[i] = sim.nextPending[sim.tail];
+        sim.nextPending[sim.tail] = i;
+    }
+    sim.tail = i;
+    sim.pending++;
+}
+
+/***************************************************************************
+* void admitArrivals(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Links every task that can join the pending list now onto it.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+***************************************************************************/
+
+void admitArrivals(struct simEngine &sim){
+    while (canAdmit(sim)){
+        addPending(sim);
+    }
+}
+
+/***************************************************************************
+* void waitArrival(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Moves the clock of an idle engine ahead to the arrival of the
+               next trace task and lets it in, with any others arriving then.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+***************************************************************************/
+
+void waitArrival(struct simEngine &sim){
+    long long arrival = sim.trace[sim.generated].arrival;
+    if (arrival > sim.clock)
+        sim.clock = arrival;
+    admitArrivals(sim);
+}
+
+/***************************************************************************
+* void initSim(struct simEngine &sim, struct memoryMap &mem, struct taskSource &source, struct taskState &process)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Prepares the simulation engine for a run. Tasks are linked into
+               the circular pending list in stream order and the counters, clock
+               and event queue are reset. Buffers of the last run of the engine
+               keep their capacity, so a worker only allocates while warming up.
+               A task stream generated up front is linked in whole. When
+               streaming only a window of tasks is drawn, and every task placed
+               into memory makes room for the next one. A trace only lets in the
+               tasks that arrive at time 0.
+* Parameters:
+* sim           I/P struct simEngine - The engine to initialize
+* mem           I/P struct memoryMap - The memory blocks
+* source        I/P struct taskSource - Where the tasks come from
+* process       I/P struct taskState - Task information changed by the run
+***************************************************************************/
+
+void initSim(struct simEngine &sim, struct memoryMap &mem, struct taskSource &source, struct taskState &process){
+    sim.process = &process;
+    sim.mem = &mem;
+    sim.gen = NULL;
+    sim.trace = NULL;
+    sim.streaming = false;
+    sim.quantum = 1;
+    sim.total = source.total;
+    sim.generated = 0;
+    sim.clock = 0;
+    sim.pending = 0;
+    sim.resident = 0;
+    sim.prevPending = 0;
+    sim.tail = 0;
+    sim.failedPlacements = 0;
+    sim.turnAround = welford();
+    sim.relative = welford();
+    sim.seq = 0;
+    sim.dispatches = 0;
+    sim.runHead = 0;
+    sim.runCount = 0;
+    sim.events.clear();
+    sim.ready.clear();
+    sim.running = -1;
+    sim.stats = runStats();
+    STAT(sim.stats.freeMemory = mem.freeSpace;)
+    for (int d : sim.activeBuckets){																						//Every bucket and level is empty again
+        sim.buckets[d] = taskFifo();
+    }
+    sim.activeBuckets.clear();
+    sim.activeReceived.clear();
+    sim.activeRate.clear();
+    for (int l = 0; l < MLFQ_LEVELS; l++){
+        sim.levels[l] = taskFifo();
+    }
+    if (source.work){																										//Whole task stream is already generated
+        int n = source.total;
+        sim.work = source.work;
+        sim.window = n;
+        process.flag.assign(n, -1);
+        process.blockLoc.assign(n, 0);
+        process.spent.assign(n, 0);
+        process.received.assign(n, 0);
+        process.started.assign(n, 0);
+        sim.readyPos.assign(n, -1);
+        sim.link.assign(n, -1);
+        sim.level.assign(n, 0);
+        sim.nextPending.resize(n);
+    }
+    else {
+        sim.work = &sim.streamed;
+        sim.streaming = true;
+        if (source.trace){
+            sim.trace = source.trace;
+        }
+        else {
+            sim.gen = &source.gen;
+        }
+        sim.window = source.window;
+        sim.streamed.size.clear();
+        sim.streamed.duration.clear();
+        sim.slotId.clear();
+        sim.freeSlots.clear();
+        sim.nextPending.clear();
+        sim.readyPos.clear();
+        sim.link.clear();
+        sim.level.clear();
+        process.flag.clear();
+        process.blockLoc.clear();
+        process.spent.clear();
+        process.received.clear();
+        process.started.clear();
+    }
+    if (sim.runQueue.size() < 16){
+        sim.runQueue.resize(16);
+    }
+    admitArrivals(sim);																										//Fill the window
+    sim.prevPending = sim.tail;																								//The first task tried is the first one in the stream
+}
+
+/***************************************************************************
+* bool openTrace(const char *path, struct traceFile &trace)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Maps a binary trace file read only and checks its header. The
+               records are not copied, runs read them straight out of the
+               mapping, so the page cache holds the trace once for every
+               policy and thread.
+* Parameters:
+* path      I/P const char * - The trace file
+* trace     O/P struct traceFile - The mapped trace
+* openTrace O/P bool - False if the file cannot be mapped or is not a trace
+***************************************************************************/
+
+bool openTrace(const char *path, struct traceFile &trace)
+{
+    trace.fd = open(path, O_RDONLY);
+    if (trace.fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(trace.fd, &info) != 0 || (size_t)info.st_size < sizeof(struct traceHeader)){
+        closeTrace(trace);
+        return false;
+    }
+    trace.bytes = info.st_size;
+    trace.map = mmap(NULL, trace.bytes, PROT_READ, MAP_PRIVATE, trace.fd, 0);
+    if (trace.map == MAP_FAILED){
+        trace.map = NULL;
+        closeTrace(trace);
+        return false;
+    }
+    madvise(trace.map, trace.bytes, MADV_SEQUENTIAL);																		//Runs read the records front to back
+    trace.header = (const struct traceHeader *)trace.map;
+    trace.records = (const struct traceRecord *)(trace.header + 1);
+    if (memcmp(trace.header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || trace.header->version != TRACE_VERSION
+        || trace.header->recordSize != sizeof(struct traceRecord)
+        || trace.header->count > (trace.bytes - sizeof(struct traceHeader)) / sizeof(struct traceRecord)){
+        closeTrace(trace);
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* void closeTrace(struct traceFile &trace)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Unmaps a trace file and closes it.
+* Parameters:
+* trace     I/P struct traceFile - The trace to close
+***************************************************************************/
+
+void closeTrace(struct traceFile &trace)
+{
+    if (trace.map)
+        munmap(trace.map, trace.bytes);
+    if (trace.fd >= 0)
+        close(trace.fd);
+    trace = traceFile();
+}
+
+/***************************************************************************
+* void mergeHistogram(struct histogram &into, const struct histogram &from)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds the values of one histogram to another. Merging is exact, so
+               the result does not depend on how the values were split up.
+* Parameters:
+* into  I/P struct histogram - The histogram added to
+* from  I/P struct histogram - The histogram added
+***************************************************************************/
+
+void mergeHistogram(struct histogram &into, const struct histogram &from)
+{
+    for (int b = 0; b < HIST_BUCKETS; b++){
+        into.counts[b] += from.counts[b];
+    }
+    into.total += from.total;
+    if (from.max > into.max)
+        into.max = from.max;
+}
+
+/***************************************************************************
+* int64_t valueAtQuantile(const struct histogram &hist, double q)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Finds the value at a quantile, given as the highest value of the
+               bucket holding it, but never more than the largest value seen.
+* Parameters:
+* hist              I/P struct histogram - The histogram
+* q                 I/P double - The quantile, 0.99 for p99
+* valueAtQuantile   O/P int64_t - The value, 0 if the histogram is empty
+***************************************************************************/
+
+int64_t valueAtQuantile(const struct histogram &hist, double q)
+{
+    if (hist.total == 0)
+        return 0;
+    uint64_t rank = (uint64_t)ceil(q * hist.total);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++){
+        seen += hist.counts[b];
+        if (seen >= rank){
+            int64_t top = b;																								//Highest value of the bucket
+            if (b >= (1 << HIST_SUB_BITS)){
+                int shift = b / (1 << (HIST_SUB_BITS - 1)) - 1;
+                int64_t sub = b - shift * (1 << (HIST_SUB_BITS - 1));
+                top = ((sub + 1) << shift) - 1;
+            }
+            return top < hist.max ? top : hist.max;
+        }
+    }
+    return hist.max;
+}
+
+/***************************************************************************
+* bool openSink(const char *path, struct taskSink &sink)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Creates the per task output file and writes its header. The file
+               gets a large stdio buffer so chunks go out in few system calls.
+* Parameters:
+* path      I/P const char * - The file to write
+* sink      O/P struct taskSink - The open output
+* openSink  O/P bool - False if the file cannot be written
+***************************************************************************/
+
+bool openSink(const char *path, struct taskSink &sink)
+{
+    sink.file = fopen(path, "wb");
+    if (sink.file == NULL)
+        return false;
+    setvbuf(sink.file, NULL, _IOFBF, 1 << 20);
+    struct tasksHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TASKS_MAGIC, sizeof(TASKS_MAGIC));
+    header.version = TASKS_VERSION;
+    header.columns = 8;
+    sink.failed = fwrite(&header, sizeof(header), 1, sink.file) != 1;
+    return !sink.failed;
+}
+
+/***************************************************************************
+* void recordTask(struct simEngine &sim, int loc, long long turnAround, double relative)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds the row of a finished task to the worker's buffered columns
+               and writes them out once TASK_CHUNK rows are waiting.
+* Parameters:
+* sim           I/P struct simEngine - The engine holding the run state
+* loc           I/P int - The task that finished
+* turnAround    I/P long long - Its turn around time
+* relative      I/P double - Its relative turn around time
+***************************************************************************/
+
+void recordTask(struct simEngine &sim, int loc, long long turnAround, double relative)
+{
+    struct taskColumns &cols = *sim.out;
+    cols.policyCol.push_back(cols.policy);
+    cols.experimentCol.push_back(cols.experiment);
+    cols.taskCol.push_back(sim.streaming ? sim.slotId[loc] : loc);
+    cols.blockCol.push_back(sim.process->blockLoc[loc]);
+    cols.startCol.push_back(sim.process->started[loc]);
+    cols.finishCol.push_back(sim.clock);
+    cols.turnAroundCol.push_back(turnAround);
+    cols.relativeCol.push_back(relative);
+    if ((int)cols.policyCol.size() == TASK_CHUNK){
+        flushColumns(cols);
+    }
+}
+
+/***************************************************************************
+* void flushColumns(struct taskColumns &cols)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Writes the buffered rows of a worker to the output file as one
+               chunk and empties the columns, keeping their capacity.
+* Parameters:
+* cols  I/P struct taskColumns - The buffered rows
+***************************************************************************/
+
+void flushColumns(struct taskColumns &cols)
+{
+    uint64_t rows = cols.policyCol.size();
+    if (rows == 0 || cols.sink == NULL)
+        return;
+    {
+        lock_guard<mutex> guard(cols.sink->lock);
+        FILE *f = cols.sink->file;
+        bool ok = fwrite(&rows, sizeof(rows), 1, f) == 1;
+        ok = ok && fwrite(cols.policyCol.data(), sizeof(uint8_t), rows, f) == rows;
+        ok = ok && fwrite(cols.experimentCol.data(), sizeof(uint32_t), rows, f) == rows;
+        ok = ok && fwrite(cols.taskCol.data(), sizeof(int64_t), rows, f) == rows;
+        ok = ok && fwrite(cols.blockCol.data(), sizeof(int32_t), rows, f) == rows;
+        ok = ok && fwrite(cols.startCol.data(), sizeof(int64_t), rows, f) == rows;
+        ok = ok && fwrite(cols.finishCol.data(), sizeof(int64_t), rows, f) == rows;
+        ok = ok && fwrite(cols.turnAroundCol.data(), sizeof(int64_t), rows, f) == rows;
+        ok = ok && fwrite(cols.relativeCol.data(), sizeof(double), rows, f) == rows;
+        if (!ok)
+            cols.sink->failed = true;
+        cols.sink->rows += rows;
+    }
+    cols.policyCol.clear();
+    cols.experimentCol.clear();
+    cols.taskCol.clear();
+    cols.blockCol.clear();
+    cols.startCol.clear();
+    cols.finishCol.clear();
+    cols.turnAroundCol.clear();
+    cols.relativeCol.clear();
+}
+
+/***************************************************************************
+* bool closeSink(struct taskSink &sink)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Closes the per task output file. Workers have to flush their
+               columns first.
+* Parameters:
+* sink      I/P struct taskSink - The output to close
+* closeSink O/P bool - False if any write failed
+***************************************************************************/
+
+bool closeSink(struct taskSink &sink)
+{
+    if (sink.file == NULL)
+        return true;
+    if (fclose(sink.file) != 0)
+        sink.failed = true;
+    sink.file = NULL;
+    return !sink.failed;
+}
+
+/***************************************************************************
+* void pushRun(struct simEngine &sim, int loc)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a task to the back of the circular run queue, growing it
+               when it is full.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* loc   I/P int - The task to add
+***************************************************************************/
+
+void pushRun(struct simEngine &sim, int loc){
+    int size = sim.runQueue.size();
+    if (sim.runCount == size){																								//Full, double it and unwrap the queue
+        vector<int> bigger(2 * size);
+        for (int i = 0; i < size; i++){
+            bigger[i] = sim.runQueue[(sim.runHead + i) % size];
+        }
+        sim.runQueue.swap(bigger);
+        sim.runHead = 0;
+        size *= 2;
+    }
+    sim.runQueue[(sim.runHead + sim.runCount) % size] = loc;
+    sim.runCount++;
+}
+
+/***************************************************************************
+* int popRun(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the task at the front of the circular run queue.
+* Parameters:
+* sim       I/P struct simEngine - The engine holding the run state
+* popRun    O/P int - The task found
+***************************************************************************/
+
+int popRun(struct simEngine &sim){
+    int loc = sim.runQueue[sim.runHead];
+    sim.runHead = (sim.runHead + 1) % (int)sim.runQueue.size();
+    sim.runCount--;
+    return loc;
+}
+
+/***************************************************************************
+* void skipPending(struct simEngine &sim, int steps)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Moves the pending scan forward as if the given amount of
+               placements had failed in a row.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* steps I/P int - The amount of failed placements
+***************************************************************************/
+
+void skipPending(struct simEngine &sim, int steps){
+    if (sim.pending == 0){
+        return;
+    }
+    steps %= sim.pending;																									//Every pending task is tried once per lap
+    for (int i = 0; i < steps; i++){
+        sim.prevPending = sim.nextPending[sim.prevPending];
+    }
+    sim.failedPlacements += steps;
+}
+
+/***************************************************************************
+* void compactMemory(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Slides every task in memory down to address 0 in address order,
+               leaving one hole at the top. The tasks and holes tile memory, so
+               the walk steps from each to the next by its length. Each moved
+               task gets its new address, and the clock moves on by the cost
+               of every unit moved while the processor is busy compacting.
+               O(M) at most, but only run when a task fits nowhere else.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state, on memory with holes
+***************************************************************************/
+
+void compactMemory(struct simEngine &sim)
+{
+    struct memoryMap &mem = *sim.mem;
+    long long moved = 0;
+    int bottom = 0;																											//Where the next task goes
+    for (int j = 0; j < mem.m; ){
+        int len = mem.holeLen[j];
+        if (len > 0){																										//Drop the hole
+            mem.holeLen[j] = 0;
+            setLeaf(mem, j, 0);
+            j += len;
+            continue;
+        }
+        int loc = mem.owner[j];
+        len = sim.work->size[loc];
+        if (j != bottom){
+            mem.owner[bottom] = loc;
+            sim.process->blockLoc[loc] = bottom;
+            moved += len;
+        }
+        bottom += len;
+        j += len;
+    }
+    int len = mem.m - bottom;
+    mem.holeLen[bottom] = len;
+    mem.holeStart[mem.m - 1] = bottom;
+    setLeaf(mem, bottom, len);
+    if (mem.fit == BEST_FIT){
+        mem.bySize.clear();
+        mem.bySize.insert({len, bottom});
+    }
+    mem.nextBlock = bottom;
+    sim.clock += mem.compactCost * moved;
+    STAT(sim.stats.compactions++;
+         sim.stats.moved += moved;)
+}
+
+/***************************************************************************
+* template <int P> void scheduleFit(struct runArena &arena, struct taskSource &source, int q, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Picks the copy of the scheduling loop built for the memory model
+               and placement algorithm the arena's memory was set up with.
+* Parameters:
+* arena     I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source    I/P struct taskSource - Where the tasks come from
+* q         I/P int - Round robin quantum
+* res       O/P struct results - Where the avg turn around times are stored
+* P         I/P int - The policy
+***************************************************************************/
+
+template <int P>
+void scheduleFit(struct runArena &arena, struct taskSource &source, int q, struct results &res){
+    switch (placementOf(arena.mem)){
+        case FIRST_FIT:
+            schedule<P, FIRST_FIT>(arena, source, q, res);
+            break;
+        case NEXT_FIT:
+            schedule<P, NEXT_FIT>(arena, source, q, res);
+            break;
+        case BEST_FIT:
+            schedule<P, BEST_FIT>(arena, source, q, res);
+            break;
+        case WORST_FIT:
+            schedule<P, WORST_FIT>(arena, source, q, res);
+            break;
+        case FREE_LIST * FITS + FIRST_FIT:
+            schedule<P, FREE_LIST * FITS + FIRST_FIT>(arena, source, q, res);
+            break;
+        case FREE_LIST * FITS + NEXT_FIT:
+            schedule<P, FREE_LIST * FITS + NEXT_FIT>(arena, source, q, res);
+            break;
+        case FREE_LIST * FITS + BEST_FIT:
+            schedule<P, FREE_LIST * FITS + BEST_FIT>(arena, source, q, res);
+            break;
+        case FREE_LIST * FITS + WORST_FIT:
+            schedule<P, FREE_LIST * FITS + WORST_FIT>(arena, source, q, res);
+            break;
+        case BUDDY_SYSTEM * FITS:
+            schedule<P, BUDDY_SYSTEM * FITS>(arena, source, q, res);
+            break;
+    }
+}
+
+/***************************************************************************
+* void srt(struct runArena &arena, struct taskSource &source, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tasks from the task stream are processed using the memory
+               placement algorithm and stored into memory. Then scheduling is
+               performed on the tasks using the srt algorithm, preempting the
+               running task when a shorter one arrives. Finally, the avg
+               turnaround time and average relative turn around time is determined
+               for all tasks.
+
+* Parameters:
+* arena         I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source        I/P struct taskSource - Where the tasks of the experiment come from
+* res           O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void srt(struct runArena &arena, struct taskSource &source, struct results &res){
+    scheduleFit<SRT_POLICY>(arena, source, 1, res);
+}
+
+
+/***************************************************************************
+* void rr(struct runArena &arena, struct taskSource &source, int q, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tasks from the task stream are processed using the memory
+               placement algorithm and stored into memory. Then scheduling is
+               performed on the tasks using the round robin algorithm. Finally, the avg
+               turnaround time and average relative turn around time is determined
+               for all tasks.
+
+* Parameters:
+* arena         I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source        I/P struct taskSource - Where the tasks of the experiment come from
+* q             I/P int - The quantum, time a task runs before going to the back of the queue
+* res           O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void rr(struct runArena &arena, struct taskSource &source, int q, struct results &res){
+    scheduleFit<RR_POLICY>(arena, source, q, res);
+}
+
+
+
+/***************************************************************************
+* void spn(struct runArena &arena, struct taskSource &source, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tasks from the task stream are processed using the memory
+               placement algorithm and stored into memory. Then scheduling is
+               performed on the tasks using the spn algorithm. Finally, the avg
+               turnaround time and average relative turn around time is determined
+               for all tasks.
+
+* Parameters:
+* arena         I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source        I/P struct taskSource - Where the tasks of the experiment come from
+* res           O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void spn(struct runArena &arena, struct taskSource &source, struct results &res){
+    scheduleFit<SPN_POLICY>(arena, source, 1, res);
+}
+
+/***************************************************************************
+* void fcfs(struct runArena &arena, struct taskSource &source, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tasks from the task stream are processed using the memory
+               placement algorithm and stored into memory. Then scheduling is
+               performed on the tasks using the fcfs algorithm. Finally, the avg
+               turnaround time and average relative turn around time is determined
+               for all tasks.
+
+* Parameters:
+* arena         I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source        I/P struct taskSource - Where the tasks of the experiment come from
+* res           O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void fcfs(struct runArena &arena, struct taskSource &source, struct results &res){
+    scheduleFit<FCFS_POLICY>(arena, source, 1, res);
+}
+
+/***************************************************************************
+* void hrrn(struct runArena &arena, struct taskSource &source, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tasks from the task stream are processed using the memory
+               placement algorithm and stored into memory. Then scheduling is
+               performed on the tasks using the hrrn algorithm. Finally, the avg
+               turnaround time and average relative turn around time is determined
+               for all tasks.
+
+* Parameters:
+* arena         I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source        I/P struct taskSource - Where the tasks of the experiment come from
+* res           O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void hrrn(struct runArena &arena, struct taskSource &source, struct results &res){
+    scheduleFit<HRRN_POLICY>(arena, source, 1, res);
+}
+
+/***************************************************************************
+* double maxRatioScalar(const double *received, const double *rate, int n, double clock)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Plain version of maxRatio, for processors without SSE4.2.
+* Parameters:
+* received          I/P const double * - Received time of each task
+* rate              I/P const double * - One over the service time of each task
+* n                 I/P int - The amount of tasks
+* clock             I/P double - Current simulated time
+* maxRatioScalar    O/P double - The largest wait / service time
+***************************************************************************/
+
+double maxRatioScalar(const double *received, const double *rate, int n, double clock)
+{
+    double top = -INFINITY;
+    for (int b = 0; b < n; b++){
+        double ratio = (clock - received[b]) * rate[b];
+        top = ratio > top ? ratio : top;
+    }
+    return top;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/***************************************************************************
+* double maxRatioSse(const double *received, const double *rate, int n, double clock)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: SSE4.2 version of maxRatio, two tasks at a time.
+* Parameters:
+* received      I/P const double * - Received time of each task
+* rate          I/P const double * - One over the service time of each task
+* n             I/P int - The amount of tasks
+* clock         I/P double - Current simulated time
+* maxRatioSse   O/P double - The largest wait / service time
+***************************************************************************/
+
+__attribute__((target("sse4.2")))
+double maxRatioSse(const double *received, const double *rate, int n, double clock)
+{
+    __m128d now = _mm_set1_pd(clock), top2 = _mm_set1_pd(-INFINITY);
+    int b = 0;
+    for (; b + 2 <= n; b += 2){
+        __m128d ratio = _mm_mul_pd(_mm_sub_pd(now, _mm_loadu_pd(received + b)), _mm_loadu_pd(rate + b));
+        top2 = _mm_max_pd(top2, ratio);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, top2);
+    double top = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    return max(top, maxRatioScalar(received + b, rate + b, n - b, clock));													//Odd task left over
+}
+
+/***************************************************************************
+* double maxRatioAvx2(const double *received, const double *rate, int n, double clock)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: AVX2 version of maxRatio, four tasks at a time.
+* Parameters:
+* received      I/P const double * - Received time of each task
+* rate          I/P const double * - One over the service time of each task
+* n             I/P int - The amount of tasks
+* clock         I/P double - Current simulated time
+* maxRatioAvx2  O/P double - The largest wait / service time
+***************************************************************************/
+
+__attribute__((target("avx2")))
+double maxRatioAvx2(const double *received, const double *rate, int n, double clock)
+{
+    __m256d now = _mm256_set1_pd(clock), top4 = _mm256_set1_pd(-INFINITY);
+    int b = 0;
+    for (; b + 4 <= n; b += 4){
+        __m256d ratio = _mm256_mul_pd(_mm256_sub_pd(now, _mm256_loadu_pd(received + b)), _mm256_loadu_pd(rate + b));
+        top4 = _mm256_max_pd(top4, ratio);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, top4);
+    double top = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+    return max(top, maxRatioScalar(received + b, rate + b, n - b, clock));													//Up to three tasks left over
+}
+#endif
+
+/***************************************************************************
+* double maxRatio(const double *received, const double *rate, int n, double clock)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the largest (clock - received) * rate over packed
+               columns. The version is picked the first time it is called, AVX2
+               or SSE4.2 when the processor has them. Every version rounds the
+               same way, so they all give the same value.
+* Parameters:
+* received  I/P const double * - Received time of each task
+* rate      I/P const double * - One over the service time of each task
+* n         I/P int - The amount of tasks
+* clock     I/P double - Current simulated time
+* maxRatio  O/P double - The largest wait / service time, -infinity for no tasks
+***************************************************************************/
+
+double maxRatio(const double *received, const double *rate, int n, double clock)
+{
+    typedef double (*ratioKernel)(const double *, const double *, int, double);
+    static const ratioKernel kernel = [](){
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+            return (ratioKernel)maxRatioAvx2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return (ratioKernel)maxRatioSse;
+#endif
+        return (ratioKernel)maxRatioScalar;
+    }();
+    return kernel(received, rate, n, clock);
+}
+
+/***************************************************************************
+* void mlfq(struct runArena &arena, struct taskSource &source, int q, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tasks from the task stream are processed using the memory
+               placement algorithm and stored into memory. Then scheduling is
+               performed on the tasks using multilevel feedback queues. Finally,
+               the avg turnaround time and average relative turn around time is
+               determined for all tasks.
+
+* Parameters:
+* arena         I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source        I/P struct taskSource - Where the tasks of the experiment come from
+* q             I/P int - The quantum of the top level, every level down doubles it
+* res           O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void mlfq(struct runArena &arena, struct taskSource &source, int q, struct results &res){
+    scheduleFit<MLFQ_POLICY>(arena, source, q, res);
+}
+
+/***************************************************************************
+* void writeStats(FILE *out, int p, int k, const struct simEngine &sim, double genNs)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Writes the counters and phase timers of a finished run as one JSON
+               line. Workers finish runs at the same time, so lines are written
+               whole under a lock.
+* Parameters:
+* out       I/P FILE * - Where to write
+* p         I/P int - The policy of the run
+* k         I/P int - The experiment of the run
+* sim       I/P struct simEngine - The engine after the run
+* genNs     I/P double - Time this run spent generating the task stream, 0 if another policy did
+***************************************************************************/
+
+void writeStats(FILE *out, int p, int k, const struct simEngine &sim, double genNs)
+{
+    static mutex lock;
+    const char *fits[] = {"first", "next", "best", "worst"};
+    const char *models[] = {"blocks", "holes", "buddy"};
+    const struct runStats &s = sim.stats;
+    lock_guard<mutex> guard(lock);
+    fprintf(out, "{\"policy\":%d,\"experiment\":%d,\"fit\":\"%s\",\"memory\":\"%s\",\"blocks\":%d,\"tasks\":%lld,\"dispatches\":%lld,"
+            "\"events\":%lld,\"place_tries\":%lld,\"place_fails\":%lld,\"fragmented\":%lld,\"forced_dispatches\":%lld,"
+            "\"preemptions\":%lld,\"requeues\":%lld,\"demotions\":%lld,\"collapsed_quanta\":%lld,\"compactions\":%lld,\"moved\":%lld,"
+            "\"peak_pending\":%d,\"peak_resident\":%d,\"gen_ns\":%.0f,\"place_ns\":%.0f,\"select_ns\":%.0f,\"event_ns\":%.0f}\n",
+            p, k, fits[sim.mem->fit], models[sim.mem->model], sim.mem->m, sim.total, sim.dispatches, s.events, s.placeTries, s.placeFails,
+            s.fragmented, s.forcedDispatches, s.preemptions, s.requeues, s.demotions, s.collapsedQuanta, s.compactions, s.moved,
+            s.peakPending, s.peakResident, genNs, s.placeNs, s.selectNs, s.eventNs);
+}
+
+/***************************************************************************
+* uint64_t hashBytes(uint64_t hash, const void *data, size_t bytes)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds bytes to a 64 bit FNV-1a hash. Start from 14695981039346656037.
+* Parameters:
+* hash      I/P uint64_t - The hash so far
+* data      I/P const void * - The bytes to add
+* bytes     I/P size_t - How many
+* hashBytes O/P uint64_t - The new hash
+***************************************************************************/
+
+uint64_t hashBytes(uint64_t hash, const void *data, size_t bytes)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < bytes; i++){
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/***************************************************************************
+* bool saveCheckpoint(const char *path, uint64_t setup, const struct runTotals &totals)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Writes the totals to path.tmp, syncs it and renames it over path,
+               so a run killed while writing leaves the last snapshot whole.
+* Parameters:
+* path              I/P const char * - The checkpoint file
+* setup             I/P uint64_t - Hash of the settings of the run
+* totals            I/P struct runTotals - The totals of the finished experiments
+* saveCheckpoint    O/P bool - False if the snapshot could not be written
+***************************************************************************/
+
+bool saveCheckpoint(const char *path, uint64_t setup, const struct runTotals &totals)
+{
+    string tmp = string(path) + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "wb");
+    if (out == NULL)
+        return false;
+    struct checkpointHeader header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.bytes = sizeof(totals);
+    header.setup = setup;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(&totals, sizeof(totals), 1, out) == 1;
+    ok = fflush(out) == 0 && ok;
+    ok = fsync(fileno(out)) == 0 && ok;																						//On disk before it replaces the last snapshot
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path) != 0){
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* int loadCheckpoint(const char *path, uint64_t setup, struct runTotals &totals)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads the totals of a snapshot written by saveCheckpoint for a run
+               with the same settings.
+* Parameters:
+* path              I/P const char * - The checkpoint file
+* setup             I/P uint64_t - Hash of the settings of the run
+* totals            O/P struct runTotals - The totals of the finished experiments
+* loadCheckpoint    O/P int - 1 if the totals were read, 0 if there is no file, -1 if
+                    it is not a checkpoint of this run
+***************************************************************************/
+
+int loadCheckpoint(const char *path, uint64_t setup, struct runTotals &totals)
+{
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+        return 0;
+    struct checkpointHeader header;
+    bool ok = fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0
+              && header.version == CHECKPOINT_VERSION && header.bytes == sizeof(totals) && header.setup == setup
+              && fread(&totals, sizeof(totals), 1, in) == 1;
+    fclose(in);
+    return ok ? 1 : -1;
+}
+
+/***************************************************************************
+* bool trimStats(const char *path, int done)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Keeps only the lines of a -p counters file whose experiment
+               is below done. A run stopped between checkpoints leaves lines
+               of experiments the resumed run does again. The kept lines go
+               to path.tmp, which is renamed over path like a checkpoint.
+* Parameters:
+* path      I/P const char * - The counters file, missing means nothing to keep
+* done      I/P int - Experiments the checkpoint holds
+* trimStats O/P bool - False if the file could not be rewritten
+***************************************************************************/
+
+bool trimStats(const char *path, int done)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+        return true;
+    string tmp = string(path) + ".tmp";
+    FILE *out = fopen(tmp.c_str(), "w");
+    if (out == NULL){
+        fclose(in);
+        return false;
+    }
+    bool ok = true;
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, in) != -1){
+        const char *field = strstr(line, "\"experiment\":");
+        if (field == NULL || atoi(field + strlen("\"experiment\":")) >= done)
+            continue;
+        ok = fputs(line, out) >= 0 && ok;
+    }
+    free(line);
+    ok = !ferror(in) && ok;
+    fclose(in);
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path) != 0){
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* uint64_t resultKey(const struct simConfig &config, int p, uint64_t seed)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Hashes everything the results of a policy on a configuration
+               depend on. The quantum only counts for rr and mlfq, so the other
+               policies share their results across quanta, and the memory model
+               only when it is not fixed blocks.
+* Parameters:
+* config    I/P struct simConfig - Memory layout, placement, quantum, distribution and task count
+* p         I/P int - The policy
+* seed      I/P uint64_t - The seed of the experiments
+* resultKey O/P uint64_t - The key
+***************************************************************************/
+
+uint64_t resultKey(const struct simConfig &config, int p, uint64_t seed)
+{
+    bool timed = p == RR_POLICY || p == MLFQ_POLICY;
+    long long fields[] = {CACHE_VERSION, p, config.fit, timed ? config.quantum : 0, config.window, config.loops, config.ulimit,
+                          config.tasks, (long long)seed};
+    uint64_t key = hashBytes(14695981039346656037ULL, fields, sizeof(fields));
+    if (config.model != FIXED_BLOCKS){																						//Left out for fixed blocks, so their keys stay what they were
+        long long memory[] = {config.model, config.compactCost};
+        key = hashBytes(key, memory, sizeof(memory));
+    }
+    return hashBytes(key, config.blocks.data(), config.blocks.size() * sizeof(int));
+}
+
+/***************************************************************************
+* int loadResults(const char *dir, uint64_t key, vector<struct results> &cached)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads the results cached under a key, those of experiments 0 on.
+               The count in the header has to match the length of the file
+               before anything is allocated for it, so a damaged file is a miss.
+* Parameters:
+* dir           I/P const char * - The cache directory
+* key           I/P uint64_t - The key from resultKey
+* cached        O/P vector<struct results> - The results of each experiment
+* loadResults   O/P int - How many experiments were read, 0 if there is no valid file
+***************************************************************************/
+
+int loadResults(const char *dir, uint64_t key, vector<struct results> &cached)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%016llx.res", dir, (unsigned long long)key);
+    cached.clear();
+    FILE *in = fopen(path, "rb");
+    if (in == NULL)
+        return 0;
+    struct cacheHeader header;
+    struct stat info;
+    if (fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0
+        && header.version == CACHE_VERSION && header.key == key && fstat(fileno(in), &info) == 0
+        && (uint64_t)info.st_size == sizeof(header) + (uint64_t)header.count * sizeof(struct results)){
+        cached.resize(header.count);
+        if (fread(cached.data(), sizeof(struct results), header.count, in) != header.count)									//Cut short, treat as missing
+            cached.clear();
+    }
+    fclose(in);
+    return cached.size();
+}
+
+/***************************************************************************
+* bool saveResults(const char *dir, uint64_t key, const vector<struct results> &cached)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Writes the results of experiments 0 on under a key. The file is
+               written next to its place and renamed over it, so a sweep reading
+               it at the same time sees the old or the new results, never half.
+* Parameters:
+* dir           I/P const char * - The cache directory, made if it is not there
+* key           I/P uint64_t - The key from resultKey
+* cached        I/P vector<struct results> - The results of each experiment
+* saveResults   O/P bool - False if the file could not be written
+***************************************************************************/
+
+bool saveResults(const char *dir, uint64_t key, const vector<struct results> &cached)
+{
+    char path[4096], tmp[4096 + 16];
+    mkdir(dir, 0777);
+    snprintf(path, sizeof(path), "%s/%016llx.res", dir, (unsigned long long)key);
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, (int)getpid());
+    FILE *out = fopen(tmp, "wb");
+    if (out == NULL)
+        return false;
+    struct cacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_VERSION;
+    header.count = cached.size();
+    header.key = key;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+              && fwrite(cached.data(), sizeof(struct results), cached.size(), out) == cached.size();
+    ok = fclose(out) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0){
+        remove(tmp);
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* bool takeJob(vector<struct workQueue> &queues, int self, int &job)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the next job for a worker thread. Workers take from the
+               back of their own queue and steal from the front of the other
+               queues once their own runs out.
+* Parameters:
+* queues    I/P vector<struct workQueue> - The job queues of all workers
+* self      I/P int - The worker looking for a job
+* job       O/P int - The job taken
+* takeJob   O/P bool - False once every queue is empty
+***************************************************************************/
+
+bool takeJob(vector<struct workQueue> &queues, int self, int &job)
+{
+    int workers = queues.size();
+    {
+        lock_guard<mutex> guard(queues[self].lock);
+        if (!queues[self].jobs.empty()){																					//Own work first
+            job = queues[self].jobs.back();
+            queues[self].jobs.pop_back();
+            return true;
+        }
+    }
+    for (int i = 1; i < workers; i++){																						//Steal from the other workers
+        struct workQueue &victim = queues[(self + i) % workers];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.jobs.empty()){
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+/***************************************************************************
+* void runJobs(int jobs, int threads, const function<void(int, int)> &work)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs jobs 0 to jobs-1 on a pool of worker threads. The jobs are
+               dealt out to the workers up front and idle workers steal from
+               busy ones. Returns once every job is done.
+* Parameters:
+* jobs      I/P int - The amount of jobs to run
+* threads   I/P int - The amount of worker threads
+* work      I/P function<void(int, int)> - Runs a single job on the given worker
+***************************************************************************/
+
+void runJobs(int jobs, int threads, const function<void(int, int)> &work)
+{
+    if (threads > jobs)
+        threads = jobs;
+    if (threads < 1)
+        threads = 1;
+    vector<struct workQueue> queues(threads);
+    for (int j = 0; j < jobs; j++){																							//Deal the jobs out to the workers
+        queues[j % threads].jobs.push_back(j);
+    }
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++){
+        workers.emplace_back([&queues, &work, t](){
+            int job;
+            while (takeJob(queues, t, job)){
+                work(job, t);
+            }
+        });
+    }
+    for (thread &worker : workers){
+        worker.join();
+    }
+}
+
+/***************************************************************************
+* void runPolicy(int p, struct runArena &arena, struct taskSource &source, const struct simConfig &config, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sets up the memory blocks of an arena and runs one scheduling
+               function on a task source.
+* Parameters:
+* p         I/P int - The policy to run
+* arena     I/P struct runArena - Buffers the run reuses
+* source    I/P struct taskSource - Where the tasks come from
+* config    I/P struct simConfig - Memory layout, placement algorithm and quantum
+* res       O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void runPolicy(int p, struct runArena &arena, struct taskSource &source, const struct simConfig &config, struct results &res)
+{
+    setMemory(arena.mem, config);
+    switch (p){
+        case FCFS_POLICY:
+            fcfs(arena, source, res);																						//Calling FCFS function
+            break;
+        case RR_POLICY:
+            rr(arena, source, config.quantum, res);																			//Calling RR function
+            break;
+        case SPN_POLICY:
+            spn(arena, source, res);																						//Calling SPN function
+            break;
+        case SRT_POLICY:
+            srt(arena, source, res);																						//Calling SRT function
+            break;
+        case HRRN_POLICY:
+            hrrn(arena, source, res);																						//Calling HRRN function
+            break;
+        case MLFQ_POLICY:
+            mlfq(arena, source, config.quantum, res);																		//Calling MLFQ function
+            break;
+    }
+}
+
+/***************************************************************************
+* void generateWork(uint64_t seed, int k, struct workload &work, const struct simConfig &config, [[maybe_unused]] double &genNs)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Draws the task stream of experiment k from a stream seeded by the
+               experiment number, if no policy of the experiment has yet.
+* Parameters:
+* seed      I/P uint64_t - The seed given on the command line
+* k         I/P int - The experiment number
+* work      O/P struct workload - The task stream of experiment k
+* config    I/P struct simConfig - Task count and distribution
+* genNs     O/P double - Time spent drawing the tasks in -DSIM_STATS builds, left alone if this call did not
+***************************************************************************/
+
+void generateWork(uint64_t seed, int k, struct workload &work, const struct simConfig &config, [[maybe_unused]] double &genNs)
+{
+    call_once(work.generated, [&](){																						//Randomizing all tasks
+        STAT(chrono::steady_clock::time_point started = chrono::steady_clock::now();)
+        struct normalSource src;
+        seedStream(src.rng, seed, k);
+        src.loops = config.loops;
+        src.ulimit = config.ulimit;
+        setTasks(work, src, config.tasks);
+        if (work.users == 0)																								//Every policy runs unless the caller said how many will
+            work.users = POLICIES;
+        STAT(genNs = elapsedNs(started);)
+    });
+}
+
+/***************************************************************************
+* void runExperiment(uint64_t seed, int k, struct workload &work, int p, const struct simConfig &config, struct runArena &arena, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs one policy on the workload of experiment k. The workload is
+               drawn from a stream seeded by the experiment number by whichever
+               policy of the experiment runs first and shared with the others.
+               The last policy to finish hands its columns on to a later
+               experiment. When streaming each policy draws the tasks from the
+               same stream itself as it needs them, and a replayed trace is read
+               by each policy straight from its mapping. The run reuses the
+               buffers of the worker's arena.
+* Parameters:
+* seed      I/P uint64_t - The seed given on the command line
+* k         I/P int - The experiment number
+* work      I/P struct workload - The task stream of experiment k
+* p         I/P int - The policy to run
+* config    I/P struct simConfig - Memory layout, placement algorithm and quantum
+* arena     I/P struct runArena - Buffers of the worker running the job
+* res       O/P struct results - Where the avg turn around times are stored
+***************************************************************************/
+
+void runExperiment(uint64_t seed, int k, struct workload &work, int p, const struct simConfig &config, struct runArena &arena, struct results &res)
+{
+    double genNs = 0;																										//Time spent generating the task stream, if this run did it
+    struct taskSource source;																								//Where this run gets its tasks from
+    source.total = config.tasks;
+    if (config.trace){																										//Replaying a trace, read tasks as they arrive
+        source.trace = config.trace->records;
+        source.window = config.window > 0 ? config.window : INT_MAX;
+    }
+    else if (config.window > 0){																							//Streaming, draw tasks as they are needed
+        seedStream(source.gen.rng, seed, k);
+        source.gen.loops = config.loops;
+        source.gen.ulimit = config.ulimit;
+        source.window = config.window;
+    }
+    else {
+        generateWork(seed, k, work, config, genNs);
+        source.work = &work;
+    }
+    if (config.sink){																										//Rows of this run go to the output file
+        arena.out.sink = config.sink;
+        arena.out.policy = p;
+        arena.out.experiment = k;
+        arena.sim.out = &arena.out;
+    }
+    else {
+        arena.sim.out = NULL;
+    }
+    arena.sim.sketch = &arena.sketch[p];
+    runPolicy(p, arena, source, config, res);
+    STAT(if (config.stats)
+             writeStats(config.stats, p, k, arena.sim, genNs);)
+    if (source.work && --work.users == 0){																					//Last policy of the experiment hands the task stream on
+        giveColumn(work.size);
+        giveColumn(work.duration);
+    }
+}
+
+/***************************************************************************
+* bool canBatch(int p, const struct simConfig &config)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tells if runs of a policy on a config can go through runBatch.
+               Only fcfs and spn on fixed blocks and task streams generated up
+               front are batched, without per task output or counters, and only
+               when the memory is small enough for every lane to keep its blocks
+               and resident tasks in fixed columns. Tasks are at least 1 big, so
+               the total memory bounds the tasks in memory. Clocks are kept in
+               ints, so the sum of the task durations has to fit in one.
+* Parameters:
+* p         I/P int - The policy
+* config    I/P struct simConfig - The settings of the runs
+* canBatch  O/P bool - True if runBatch gives the same results as runExperiment
+***************************************************************************/
+
+bool canBatch(int p, const struct simConfig &config)
+{
+    if ((p != FCFS_POLICY && p != SPN_POLICY) || config.model != FIXED_BLOCKS || config.window > 0 || config.trace || config.sink || config.stats)
+        return false;
+    if (config.blocks.empty() || (int)config.blocks.size() > BATCH_BLOCKS)
+        return false;
+    long long memory = 0;
+    for (int b : config.blocks){
+        memory += b;
+    }
+    double longest = max(1, config.loops * (config.ulimit - 1));															//Longest task duration
+    return memory <= BATCH_SLOTS && config.tasks * longest < INT_MAX;
+}
+
+/***************************************************************************
+* template <int ORDER, int FIT> void scheduleBatch(struct runArena &arena, struct workload *works, int lanes, const struct simConfig &config, struct latencySketch &sketch, struct results *res, int stride)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs fcfs or spn on up to BATCH_LANES task streams in lock-step.
+               Every step takes the next pending task of each lane and looks for
+               a block for it. Lanes that placed their task are done for the
+               step, the others pick the ready task with the smallest key and run
+               it to the end. Lanes go different ways at every step, so both ways
+               are worked out for all of them in loops across the lanes with
+               masks picking what each lane keeps. Those loops have no branches
+               and one type each, so the compiler turns them into vector code.
+               Only reading the task columns and the slots of each lane's tasks
+               is done lane by lane, they sit at different places in every lane.
+               This is the scalar engine's loop step for step, so each lane gives
+               the same results as schedule. Inlined into a plain and an AVX2 copy.
+* Parameters:
+* arena     I/P struct runArena - Buffers the batch reuses
+* works     I/P struct workload * - The task streams, one per lane
+* lanes     I/P int - Lanes in use, the rest run lane 0's tasks and are thrown away
+* config    I/P struct simConfig - Memory layout and task count
+* sketch    O/P struct latencySketch - Where the turn around times are recorded
+* res       O/P struct results - Result slot of the first lane
+* stride    I/P int - Distance from one lane's result slot to the next
+* ORDER     I/P int - BY_RECEIVED for fcfs or BY_DURATION for spn
+* FIT       I/P int - Placement algorithm
+***************************************************************************/
+
+template <int ORDER, int FIT>
+__attribute__((always_inline)) inline void scheduleBatch(struct runArena &arena, struct workload *works, int lanes, const struct simConfig &config,
+                                                         struct latencySketch &sketch, struct results *res, int stride)
+{
+    const int L = BATCH_LANES;
+    int n = config.tasks;
+    int m = config.blocks.size();
+    const uint16_t *size[L];																								//Columns of each lane's task stream
+    const uint16_t *duration[L];
+    int *next[L];																											//Circular pending list of each lane
+    int clock[L] = {}, pending[L], resident[L] = {}, prev[L], nextBlock[L] = {};
+    int freeMem[BATCH_BLOCKS][L];																							//Free space of each block
+    long long slotKey[BATCH_SLOTS][L];																						//Received time or duration of the task in each slot above the task, so ties go to the earlier task, LLONG_MAX when the slot is free
+    int slotBlock[BATCH_SLOTS][L] = {}, slotReceived[BATCH_SLOTS][L] = {};
+    uint64_t used[L] = {};																									//Slots holding a task in each lane
+    double count[L] = {}, taMean[L] = {}, taM2[L] = {}, relMean[L] = {}, relM2[L] = {};										//Running stats of each lane, see addSample
+    arena.batchNext.resize((size_t)n * L);
+    for (int l = 0; l < L; l++){
+        const struct workload &work = works[l < lanes ? l : 0];
+        size[l] = work.size.data();
+        duration[l] = work.duration.data();
+        next[l] = &arena.batchNext[(size_t)l * n];
+        for (int i = 0; i < n; i++){
+            next[l][i] = i + 1 < n ? i + 1 : 0;
+        }
+        pending[l] = l < lanes ? n : 0;
+        prev[l] = n - 1;																									//The first task tried is the first one in the stream
+        for (int j = 0; j < m; j++){
+            freeMem[j][l] = config.blocks[j];
+        }
+        for (int s = 0; s < BATCH_SLOTS; s++){
+            slotKey[s][l] = LLONG_MAX;
+        }
+    }
+    int top = 0;																											//Slots below this may be in use in some lane
+    bool live = lanes > 0;
+    while (live){
+        int task[L], want[L], block[L], place[L], run[L];
+        for (int l = 0; l < L; l++){																						//Next pending task of each lane, lanes with none want more than any block has
+            task[l] = next[l][prev[l]];
+            want[l] = pending[l] > 0 ? size[l][task[l]] : INT_MAX;
+        }
+        if constexpr (FIT == FIRST_FIT){																					//Lowest block that fits
+            for (int l = 0; l < L; l++){
+                block[l] = -1;
+            }
+            for (int j = m - 1; j >= 0; j--){
+                for (int l = 0; l < L; l++){
+                    block[l] = freeMem[j][l] >= want[l] ? j : block[l];
+                }
+            }
+        }
+        else if constexpr (FIT == NEXT_FIT){																				//Lowest block that fits from the last one used, else from the start
+            int wrapped[L];
+            for (int l = 0; l < L; l++){
+                block[l] = -1;
+                wrapped[l] = -1;
+            }
+            for (int j = m - 1; j >= 0; j--){
+                for (int l = 0; l < L; l++){
+                    bool fits = freeMem[j][l] >= want[l];
+                    wrapped[l] = fits ? j : wrapped[l];
+                    block[l] = fits & (j >= nextBlock[l]) ? j : block[l];
+                }
+            }
+            for (int l = 0; l < L; l++){
+                block[l] = block[l] >= 0 ? block[l] : wrapped[l];
+                nextBlock[l] = block[l] >= 0 ? block[l] : nextBlock[l];
+            }
+        }
+        else if constexpr (FIT == BEST_FIT){																				//Least free space that fits, first on ties
+            int least[L];
+            for (int l = 0; l < L; l++){
+                block[l] = -1;
+                least[l] = INT_MAX;
+            }
+            for (int j = 0; j < m; j++){
+                for (int l = 0; l < L; l++){
+                    bool better = (freeMem[j][l] >= want[l]) & (freeMem[j][l] < least[l]);
+                    least[l] = better ? freeMem[j][l] : least[l];
+                    block[l] = better ? j : block[l];
+                }
+            }
+        }
+        else {																												//Most free space, first on ties, if the task fits in it
+            int most[L];
+            for (int l = 0; l < L; l++){
+                block[l] = 0;
+                most[l] = freeMem[0][l];
+            }
+            for (int j = 1; j < m; j++){
+                for (int l = 0; l < L; l++){
+                    bool better = freeMem[j][l] > most[l];
+                    most[l] = better ? freeMem[j][l] : most[l];
+                    block[l] = better ? j : block[l];
+                }
+            }
+            for (int l = 0; l < L; l++){
+                block[l] = most[l] >= want[l] ? block[l] : -1;
+            }
+        }
+        for (int l = 0; l < L; l++){
+            place[l] = (pending[l] > 0) & (block[l] >= 0);
+            run[l] = (block[l] < 0) & (resident[l] > 0);
+        }
+        for (int l = 0; l < L; l++){																						//Unlink placed tasks and put them in a free slot, other lanes write back what was there
+            int i = task[l];
+            int *list = next[l];
+            list[prev[l]] = place[l] ? list[i] : list[prev[l]];
+            int s = __builtin_ctzll(~used[l] | 1ULL << 63);																	//With all 64 slots in use this is slot 63, which is left as it is
+            used[l] |= (uint64_t)place[l] << s;
+            top = max(top, place[l] ? s + 1 : 0);
+            long long key = ORDER == BY_RECEIVED ? clock[l] : duration[l][i];
+            slotKey[s][l] = place[l] ? key << 32 | i : slotKey[s][l];
+            slotBlock[s][l] = place[l] ? block[l] : slotBlock[s][l];
+            slotReceived[s][l] = place[l] ? clock[l] : slotReceived[s][l];
+        }
+        int anyRun = 0;
+        for (int l = 0; l < L; l++){
+            prev[l] = (pending[l] > 0) & (block[l] < 0) ? task[l] : prev[l];												//Failed lanes move on to the next pending task
+            pending[l] -= place[l];
+            resident[l] += place[l];
+            anyRun |= run[l];
+        }
+        for (int j = 0; j < m; j++){
+            for (int l = 0; l < L; l++){
+                freeMem[j][l] -= (block[l] == j) & place[l] ? want[l] : 0;
+            }
+        }
+        if (!anyRun)
+            continue;
+        long long best[L], at[L];
+        for (int l = 0; l < L; l++){
+            best[l] = LLONG_MAX;
+            at[l] = 0;
+        }
+        for (int s = 0; s < top; s++){																						//Smallest key of each lane
+            for (int l = 0; l < L; l++){
+                bool better = slotKey[s][l] < best[l];
+                best[l] = better ? slotKey[s][l] : best[l];
+                at[l] = better ? s : at[l];
+            }
+        }
+        int ran[L], freed[L], from[L], received[L];
+        for (int l = 0; l < L; l++){																						//Read the picked task of each lane and free its slot in the lanes that run it
+            int s = at[l];
+            int i = run[l] ? (int)best[l] : 0;
+            ran[l] = duration[l][i];
+            freed[l] = size[l][i];
+            from[l] = slotBlock[s][l];
+            received[l] = slotReceived[s][l];
+            used[l] &= ~((uint64_t)run[l] << s);
+            slotKey[s][l] = run[l] ? LLONG_MAX : slotKey[s][l];
+        }
+        int ta[L];
+        for (int l = 0; l < L; l++){																						//Run the tasks to the end
+            clock[l] += run[l] ? ran[l] : 0;
+            ta[l] = clock[l] - received[l];
+            resident[l] -= run[l];
+        }
+        for (int j = 0; j < m; j++){
+            for (int l = 0; l < L; l++){
+                freeMem[j][l] += (from[l] == j) & run[l] ? freed[l] : 0;
+            }
+        }
+        double rel[L];
+        for (int l = 0; l < L; l++){																						//Welford's method as in addSample, left alone in lanes that did not run
+            double x = ta[l];
+            rel[l] = x / (run[l] ? ran[l] : 1);
+            double n1 = count[l] + 1;
+            double delta = x - taMean[l];
+            double mean = taMean[l] + delta / n1;
+            double m2 = taM2[l] + delta * (x - mean);
+            double relDelta = rel[l] - relMean[l];
+            double relMeanNext = relMean[l] + relDelta / n1;
+            double relM2Next = relM2[l] + relDelta * (rel[l] - relMeanNext);
+            taMean[l] = run[l] ? mean : taMean[l];
+            taM2[l] = run[l] ? m2 : taM2[l];
+            relMean[l] = run[l] ? relMeanNext : relMean[l];
+            relM2[l] = run[l] ? relM2Next : relM2[l];
+            count[l] = run[l] ? n1 : count[l];
+        }
+        top = 0;
+        live = false;
+        for (int l = 0; l < L; l++){																						//Lanes that did not run add nothing to bucket 0
+            double thousandths = rel[l] * RELATIVE_SCALE;
+            int64_t rounded = (int64_t)thousandths;
+            rounded += thousandths - rounded >= 0.5;																		//llround of a value that is not negative
+            recordValues(sketch.turnAround, run[l] ? ta[l] : 0, run[l]);
+            recordValues(sketch.relative, run[l] ? rounded : 0, run[l]);
+            top = max(top, 64 - __builtin_clzll(used[l] | 1));
+            live |= (pending[l] > 0) | (resident[l] > 0);
+        }
+    }
+    for (int l = 0; l < lanes; l++){
+        struct welford taStats, relStats;
+        taStats.count = relStats.count = count[l];
+        taStats.mean = taMean[l];
+        taStats.m2 = taM2[l];
+        relStats.mean = relMean[l];
+        relStats.m2 = relM2[l];
+        res[l * stride].ttat = taStats.mean;
+        res[l * stride].rtat = relStats.mean;
+        res[l * stride].ttatVar = variance(taStats);
+        res[l * stride].rtatVar = variance(relStats);
+    }
+}
+
+/***************************************************************************
+* template <int ORDER> void scheduleBatchFit(struct runArena &arena, struct workload *works, int lanes, const struct simConfig &config, struct latencySketch &sketch, struct results *res, int stride)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Picks the copy of the lock-step loop built for the placement
+               algorithm of the config.
+* Parameters:
+* arena     I/P struct runArena - Buffers the batch reuses
+* works     I/P struct workload * - The task streams, one per lane
+* lanes     I/P int - Lanes in use
+* config    I/P struct simConfig - Memory layout, placement algorithm and task count
+* sketch    O/P struct latencySketch - Where the turn around times are recorded
+* res       O/P struct results - Result slot of the first lane
+* stride    I/P int - Distance from one lane's result slot to the next
+* ORDER     I/P int - BY_RECEIVED for fcfs or BY_DURATION for spn
+***************************************************************************/
+
+template <int ORDER>
+__attribute__((always_inline)) inline void scheduleBatchFit(struct runArena &arena, struct workload *works, int lanes, const struct simConfig &config,
+                                                            struct latencySketch &sketch, struct results *res, int stride)
+{
+    switch (config.fit){
+        case FIRST_FIT:
+            scheduleBatch<ORDER, FIRST_FIT>(arena, works, lanes, config, sketch, res, stride);
+            break;
+        case NEXT_FIT:
+            scheduleBatch<ORDER, NEXT_FIT>(arena, works, lanes, config, sketch, res, stride);
+            break;
+        case BEST_FIT:
+            scheduleBatch<ORDER, BEST_FIT>(arena, works, lanes, config, sketch, res, stride);
+            break;
+        case WORST_FIT:
+            scheduleBatch<ORDER, WORST_FIT>(arena, works, lanes, config, sketch, res, stride);
+            break;
+    }
+}
+
+/***************************************************************************
+* void scheduleBatchPlain(struct runArena &arena, struct workload *works, int lanes, int p, const struct simConfig &config, struct results *res, int stride)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: The lock-step loop built for any processor, its loops across the
+               lanes use the widest vectors the build targets.
+* Parameters:
+* arena     I/P struct runArena - Buffers the batch reuses
+* works     I/P struct workload * - The task streams, one per lane
+* lanes     I/P int - Lanes in use
+* p         I/P int - FCFS_POLICY or SPN_POLICY
+* config    I/P struct simConfig - Memory layout, placement algorithm and task count
+* res       O/P struct results - Result slot of the first lane
+* stride    I/P int - Distance from one lane's result slot to the next
+***************************************************************************/
+
+void scheduleBatchPlain(struct runArena &arena, struct workload *works, int lanes, int p, const struct simConfig &config,
+                        struct results *res, int stride)
+{
+    if (p == FCFS_POLICY)
+        scheduleBatchFit<BY_RECEIVED>(arena, works, lanes, config, arena.sketch[p], res, stride);
+    else
+        scheduleBatchFit<BY_DURATION>(arena, works, lanes, config, arena.sketch[p], res, stride);
+}
+
+/***************************************************************************
+* void scheduleBatchAvx2(struct runArena &arena, struct workload *works, int lanes, int p, const struct simConfig &config, struct results *res, int stride)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: The lock-step loop built for AVX2, where the slot keys and
+               running stats of all four lanes fit in one register.
+* Parameters:
+* arena     I/P struct runArena - Buffers the batch reuses
+* works     I/P struct workload * - The task streams, one per lane
+* lanes     I/P int - Lanes in use
+* p         I/P int - FCFS_POLICY or SPN_POLICY
+* config    I/P struct simConfig - Memory layout, placement algorithm and task count
+* res       O/P struct results - Result slot of the first lane
+* stride    I/P int - Distance from one lane's result slot to the next
+***************************************************************************/
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+void scheduleBatchAvx2(struct runArena &arena, struct workload *works, int lanes, int p, const struct simConfig &config,
+                       struct results *res, int stride)
+{
+    if (p == FCFS_POLICY)
+        scheduleBatchFit<BY_RECEIVED>(arena, works, lanes, config, arena.sketch[p], res, stride);
+    else
+        scheduleBatchFit<BY_DURATION>(arena, works, lanes, config, arena.sketch[p], res, stride);
+}
+#endif
+
+/***************************************************************************
+* void runBatch(uint64_t seed, int k, int lanes, struct workload *works, int p, const struct simConfig &config, struct runArena &arena, struct results *res, int stride)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs one policy on experiments k to k + lanes - 1 in lock-step,
+               drawing their task streams if no other policy has yet. Each lane
+               gives the results runExperiment would, config has to pass
+               canBatch for the policy.
+* Parameters:
+* seed      I/P uint64_t - The seed given on the command line
+* k         I/P int - The first experiment number
+* lanes     I/P int - Experiments in the batch, at most BATCH_LANES
+* works     I/P struct workload * - The task streams of the experiments
+* p         I/P int - FCFS_POLICY or SPN_POLICY
+* config    I/P struct simConfig - Memory layout, placement algorithm and task count
+* arena     I/P struct runArena - Buffers of the worker running the batch
+* res       O/P struct results - Result slot of experiment k
+* stride    I/P int - Distance from one experiment's result slot to the next
+***************************************************************************/
+
+void runBatch(uint64_t seed, int k, int lanes, struct workload *works, int p, const struct simConfig &config, struct runArena &arena,
+              struct results *res, int stride)
+{
+    double genNs = 0;
+    for (int l = 0; l < lanes; l++){
+        generateWork(seed, k + l, works[l], config, genNs);
+    }
+    typedef void (*batchKernel)(struct runArena &, struct workload *, int, int, const struct simConfig &, struct results *, int);
+    static const batchKernel kernel = [](){
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+            return (batchKernel)scheduleBatchAvx2;
+#endif
+        return (batchKernel)scheduleBatchPlain;
+    }();
+    kernel(arena, works, lanes, p, config, res, stride);
+    for (int l = 0; l < lanes; l++){																						//Last policy of an experiment hands the task stream on
+        if (--works[l].users == 0){
+            giveColumn(works[l].size);
+            giveColumn(works[l].duration);
+        }
+    }
+}
+
+/***************************************************************************
+* void initRing(struct batchRing &ring, size_t size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Empties a ring and makes room for at least size batches.
+* Parameters:
+* ring      O/P struct batchRing - The ring
+* size      I/P size_t - Batches the ring has to hold at once
+***************************************************************************/
+
+void initRing(struct batchRing &ring, size_t size)
+{
+    size_t cells = 1;
+    while (cells < size){
+        cells *= 2;
+    }
+    ring.cells = vector<struct ringCell>(cells);
+    ring.mask = cells - 1;
+    for (size_t i = 0; i < cells; i++){
+        ring.cells[i].seq.store(i, memory_order_relaxed);
+    }
+    ring.head.store(0, memory_order_relaxed);
+    ring.tail.store(0, memory_order_relaxed);
+}
+
+/***************************************************************************
+* void pushRing(struct batchRing &ring, struct workBatch *batch)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a batch pointer to the back of a ring. A pusher claims a
+               position by moving head on with a compare and swap, but only
+               once the cell there has been popped for the last time round,
+               which its sequence number tells. The pointer is written before
+               the sequence number is released, so a popper that sees the new
+               sequence number sees the pointer. Sleeps while the ring is full.
+* Parameters:
+* ring      I/P struct batchRing - The ring
+* batch     I/P struct workBatch * - The batch, NULL tells a worker to stop
+***************************************************************************/
+
+void pushRing(struct batchRing &ring, struct workBatch *batch)
+{
+    size_t pos = ring.head.load(memory_order_relaxed);
+    while (true){
+        struct ringCell &cell = ring.cells[pos & ring.mask];
+        intptr_t diff = (intptr_t)cell.seq.load(memory_order_acquire) - (intptr_t)pos;
+        if (diff == 0){																										//Free, claim it
+            if (ring.head.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                cell.batch = batch;
+                cell.seq.store(pos + 1, memory_order_release);
+                wakeRing(ring);
+                return;
+            }
+        }
+        else if (diff < 0){																									//Still full from the last time round
+            waitRing(ring, cell, pos);
+            pos = ring.head.load(memory_order_relaxed);
+        }
+        else {																												//Another pusher took it
+            pos = ring.head.load(memory_order_relaxed);
+        }
+    }
+}
+
+/***************************************************************************
+* struct workBatch *popRing(struct batchRing &ring)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the batch pointer at the front of a ring, sleeping while
+               the ring is empty. The mirror image of pushRing, a popped cell
+               gets the sequence number of its position on the next time round.
+* Parameters:
+* ring      I/P struct batchRing - The ring
+* popRing   O/P struct workBatch * - The batch
+***************************************************************************/
+
+struct workBatch *popRing(struct batchRing &ring)
+{
+    size_t pos = ring.tail.load(memory_order_relaxed);
+    while (true){
+        struct ringCell &cell = ring.cells[pos & ring.mask];
+        intptr_t diff = (intptr_t)cell.seq.load(memory_order_acquire) - (intptr_t)(pos + 1);
+        if (diff == 0){																										//Holds a batch, claim it
+            if (ring.tail.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)){
+                struct workBatch *batch = cell.batch;
+                cell.seq.store(pos + ring.mask + 1, memory_order_release);
+                wakeRing(ring);
+                return batch;
+            }
+        }
+        else if (diff < 0){																									//Nothing pushed there yet
+            waitRing(ring, cell, pos + 1);
+            pos = ring.tail.load(memory_order_relaxed);
+        }
+        else {																												//Another popper took it
+            pos = ring.tail.load(memory_order_relaxed);
+        }
+    }
+}
+
+/***************************************************************************
+* void waitRing(struct batchRing &ring, const struct ringCell &cell, size_t seq)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sleeps until the sequence number of a cell reaches seq. The
+               sleeper is counted before the cell is looked at again under
+               the lock, and wakeRing reads the count with a read-modify-write
+               after releasing the cell. Either that reads the new count, or
+               it comes first in the order of the count and the sleeper sees
+               the released cell, so a wake up cannot be missed.
+* Parameters:
+* ring      I/P struct batchRing - The ring
+* cell      I/P struct ringCell - The cell the caller waits on
+* seq       I/P size_t - Sequence number that lets the caller go on
+***************************************************************************/
+
+void waitRing(struct batchRing &ring, const struct ringCell &cell, size_t seq)
+{
+    unique_lock<mutex> hold(ring.lock);
+    ring.sleepers.fetch_add(1, memory_order_acq_rel);
+    ring.moved.wait(hold, [&](){
+        return (intptr_t)(cell.seq.load(memory_order_acquire) - seq) >= 0;
+    });
+    ring.sleepers.fetch_sub(1, memory_order_relaxed);
+}
+
+/***************************************************************************
+* void wakeRing(struct batchRing &ring)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Wakes the threads asleep on a ring after a cell changed hands.
+               Without sleepers it costs one read-modify-write, so the ring
+               only takes its lock when a thread really waits.
+* Parameters:
+* ring      I/P struct batchRing - The ring
+***************************************************************************/
+
+void wakeRing(struct batchRing &ring)
+{
+    if (ring.sleepers.fetch_add(0, memory_order_acq_rel) > 0){
+        lock_guard<mutex> hold(ring.lock);																					//A sleeper between its check and its wait holds the lock
+        ring.moved.notify_all();
+    }
+}
+
+/***************************************************************************
+* void runPipeline(vector<struct workBatch> &batches, int threads, uint64_t seed, const struct simConfig &config, vector<struct runArena> &arenas, const function<void(struct workBatch &)> &aggregate)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs every policy on the experiments of some batches in three
+               stages joined by rings. A generator thread draws the task
+               streams of each batch in turn and pushes its pointer once per
+               policy, then one NULL per worker. Each worker pops a pointer,
+               runs the next policy of that batch on all its lanes, lock-step
+               when canBatch allows, and pushes the pointer on to the calling
+               thread once the last policy of the batch is done. The calling
+               thread hands finished batches to aggregate in the order of the
+               vector, however they come in, so totals do not depend on the
+               amount of threads. Only pointers move, the streams and results
+               stay where the batches point. When streaming, or counting with
+               -DSIM_STATS where each run times its own drawing, the generator
+               leaves drawing to the runs.
+* Parameters:
+* batches   I/P vector<struct workBatch> - The batches, in experiment order
+* threads   I/P int - The amount of worker threads, at most arenas.size()
+* seed      I/P uint64_t - The seed given on the command line
+* config    I/P struct simConfig - Memory layout, placement algorithm and task count
+* arenas    I/P vector<struct runArena> - Buffers of each worker
+* aggregate I/P function<void(struct workBatch &)> - Adds up the results of a finished batch
+***************************************************************************/
+
+void runPipeline(vector<struct workBatch> &batches, int threads, uint64_t seed, const struct simConfig &config, vector<struct runArena> &arenas,
+                 const function<void(struct workBatch &)> &aggregate)
+{
+    int count = batches.size();
+    threads = max(1, min(threads, count * POLICIES));
+    struct batchRing ready, done;																							//Generator to workers, and workers to the calling thread
+    initRing(ready, (size_t)PIPELINE_DEPTH * threads * POLICIES);
+    initRing(done, count);																									//Room for every batch, so a worker never waits on the calling thread
+    thread generator([&](){
+        bool draw = config.window == 0 && !config.trace && !config.stats;
+        double genNs = 0;
+        for (struct workBatch &batch : batches){
+            for (int l = 0; l < batch.lanes && draw; l++){
+                generateWork(seed, batch.first + l, batch.works[l], config, genNs);
+            }
+            for (int p = 0; p < POLICIES; p++){
+                pushRing(ready, &batch);
+            }
+        }
+        for (int t = 0; t < threads; t++){
+            pushRing(ready, NULL);
+        }
+    });
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++){
+        workers.emplace_back([&, t](){
+            struct workload unused;																							//Stands in for the task streams when streaming
+            while (struct workBatch *batch = popRing(ready)){
+                int p = batch->nextPolicy++;
+                if (canBatch(p, config))
+                    runBatch(seed, batch->first, batch->lanes, batch->works, p, config, arenas[t], &batch->res[p], POLICIES);
+                else {
+                    for (int l = 0; l < batch->lanes; l++){
+                        runExperiment(seed, batch->first + l, batch->works ? batch->works[l] : unused, p, config, arenas[t],
+                                      batch->res[l * POLICIES + p]);
+                    }
+                }
+                if (++batch->finished == POLICIES)
+                    pushRing(done, batch);
+            }
+        });
+    }
+    vector<char> finished(count, 0);
+    for (int next = 0; next < count; ){																						//Hand the batches on in order
+        struct workBatch *batch = popRing(done);
+        finished[batch - batches.data()] = 1;
+        while (next < count && finished[next]){
+            aggregate(batches[next++]);
+        }
+    }
+    generator.join();
+    for (thread &worker : workers){
+        worker.join();
+    }
+}
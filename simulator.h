@@ -0,0 +1,1510 @@
+/***************************************************************************
+* File: simulator.h
+* Author: Venkata Bapanapalli
+* Procedures:
+* runJobs, takeJob - Work stealing thread pool that runs the (experiment, policy) jobs.
+
+* runPolicy - Runs one scheduling function on a task source with the memory layout of a config.
+
+* runExperiment - Runs one policy on the workload of one experiment, generating the workload
+              if it is the first policy of the experiment to run. Each worker keeps a runArena
+              of buffers that every run it does reuses.
+
+* takeColumn, giveColumn - Pool of task stream columns handed from finished experiments to new
+              ones, so the experiment loop stops allocating once the pool is warm.
+
+* seedStream, nextRandom - xoshiro256** random number streams. Each experiment draws from
+              its own stream of the seed given on the command line.
+
+* nextNormal, drawTask - Draw the tasks of a task stream one at a time, cutting each 64 bit
+              random draw into as many uniform values as it holds.
+
+ * uniform   - uniform random number generator, used to generate random numbers for the randomization
+              of task size and duration.
+
+* normal    - normal random number generator, used to generate random numbers for the randomization
+              of task size and duration.
+
+* schedule - Scheduling loop shared by every policy. The policy and the placement
+              algorithm are template parameters, so every pair is compiled into its own loop
+              with no run time switches left in it. New policies and fits can be added by
+              instantiating it from other code that includes this header.
+
+* fcfs  - Function will use the selected placement algorithm to place tasks from the task info
+          stream into memory. The function then does scheduling using the first come first serve
+          algorithm.
+
+* rr   - Function will use the selected placement algorithm to place tasks from the task info
+         stream into memory. The function then does scheduling using the round robin algorithm
+         with quantum q.
+
+* spn   - Function will use the selected placement algorithm to place tasks from the task info
+          stream into memory. The function then does scheduling using the shortest process next
+          algorithm.
+
+* srt   - Function will use the selected placement algorithm to place tasks from the task info
+          stream into memory. The function then does scheduling using the shortest remaining time
+          algorithm.
+
+* hrrn  - Function will use the selected placement algorithm to place tasks from the task info
+          stream into memory. The function then does scheduling using the highest response ratio
+          next algorithm.
+
+* mlfq  - Function will use the selected placement algorithm to place tasks from the task info
+          stream into memory. The function then does scheduling using multilevel feedback queues
+          with quantum q doubling at every level.
+
+* newSlot, addPending - Feed a run its tasks. In streaming mode tasks are
+              drawn as the pending window needs them and finished tasks only live on in
+              running stats, so memory is bounded by the tasks waiting or in memory.
+
+* addSample, variance, storeResults - Welford running mean and variance of turn around times.
+
+* tCritical, ciHalfWidth - 95% confidence intervals of a mean, used to decide when enough
+              experiments have been run.
+
+* bucketOf, recordValue, recordValues, mergeHistogram, valueAtQuantile - Fixed size log-linear histograms
+              of turn around times. Each worker keeps one per policy, they are added up at the
+              end and give p50 to p99.9 and max within 0.8% without keeping every task.
+
+* setTasks - Function will set task duration and task size of a value between 1-16. All the tasks
+              that have a task size or duration that is less than 1 is set to 1. Sizes and durations
+              are kept in packed columns shared by all policies of an experiment.
+
+* setBlocks, setLeaf, resizeBlock, searchFit, findBlock - Memory blocks indexed by free space. First,
+              next, best and worst fit placement each pick a block in O(log m). The memory model
+              and the fit are one template parameter of resizeBlock and findBlock, see placementOf.
+
+* setMemory, placementOf - Set up the memory model of a config, fixed blocks, holes or a buddy
+              system, and tell which copy of the scheduling loop runs on it.
+
+* setHoles, takeHole, giveHole, compactMemory - Variable partitions. Memory is one range of
+              addresses and a task takes exactly its size from the start of a hole. Holes sit in
+              the segment tree and size index of the fixed blocks with one leaf per address, so
+              the four fits work as they are in O(log M), and boundary tags let a freed task
+              merge with the holes on both sides in O(1). With a compaction cost a task that
+              only fits into the holes taken together slides every task down to address 0 first,
+              and the clock moves on by the cost of each unit moved.
+
+* setBuddies, buddyOrder, findBuddy, takeBuddy, giveBuddy, pushBuddy, dropBuddy - Binary buddy
+              system. Blocks are powers of two aligned to their size, kept in one free list per
+              order. A task takes the smallest free block that holds it, halved down to its size,
+              and a freed block merges with its buddy for as long as the buddy is free, so both
+              take O(log M). Memory past the layout's total is never free.
+
+* parseBlocks - Reads a memory layout such as 16,16,16,8 from the command line.
+
+* initSim, placeNext, dispatch, completeTask, nextEvent - Discrete-event engine shared by the
+              scheduling functions. Pending and resident tasks are kept in lists with counters
+              and time only moves forward by popping the next event off the event queue.
+              The engine counts its dispatches for the benchmarks.
+
+* canAdmit, admitArrivals, waitArrival - Let tasks of a replayed trace join the pending list
+              once they have arrived. Arrivals are let in at the next scheduling point, and an
+              idle engine jumps ahead to the next arrival.
+
+* openTrace, closeTrace - Map a binary trace file so runs read its fixed size records in
+              place, however many there are.
+
+* openSink, recordTask, flushColumns, closeSink - Optional per task output. Every finished
+              task becomes a row with its policy, experiment, stream position, block, first run,
+              finish, turn around and relative turn around time. Each worker buffers TASK_CHUNK
+              rows and writes them as one chunk of columns, so the file is read without any
+              parsing: a tasksHeader, then chunks of a uint64 row count followed by the columns
+              policy uint8, experiment uint32, task int64, block int32, start, finish and turn
+              around int64 and relative double, each rows values long.
+
+* pushRun, popRun, skipPending - Circular run queue used by rr.
+
+* popReady - Picks the next task in memory to run for fcfs and spn off a ready queue
+              kept in policy order.
+
+* siftReady, pushReady, decreaseKey, runShortest - Preemptive srt. The ready heap knows where
+              each task sits in it, so the running task stays on top and its remaining time is
+              lowered in place. A trace task arriving while it runs is placed and pushed in
+              O(log r) and takes the processor if it is shorter than what is left.
+
+* pushFifo, popFifo, pushBucket, popHighestRatio, popFeedback - Ready queues of hrrn and mlfq.
+              Tasks with the same service time keep their response ratio order as time
+              passes, so hrrn queues them by service time and only compares the front of each
+              queue, one per distinct service time in memory. Mlfq takes the front of the
+              highest level that has a task in O(1).
+
+* maxRatio - Largest wait / service time over the packed fronts of the hrrn buckets, with
+              AVX2, SSE4.2 and plain versions picked by what the processor supports.
+
+* STAT, elapsedNs, writeStats - Optional counters and phase timers. Built with -DSIM_STATS
+              every run counts its placement probes and failures, failures with enough free
+              memory in total, dispatches forced by a failed placement, preemptions, requeues
+              and demotions, and times generation, placement, selection and events, written as
+              one JSON line per run. Otherwise STAT drops its statements and nothing is left.
+
+* hashBytes, saveCheckpoint, loadCheckpoint - Snapshots of the totals of the finished
+              experiments. Experiment k is seeded from the seed and k alone, so the totals and
+              the next experiment number are all a restarted run needs to carry on and print
+              the same results. A snapshot replaces the last one only once it is fully written.
+
+* trimStats - Drops the -p lines of experiments past the last checkpoint, so a resumed run
+              does not write them twice.
+
+* generateWork - Draws the task stream of an experiment once for every policy that runs on it.
+
+* canBatch, runBatch, scheduleBatch - Lock-step fcfs and spn. A batch runs BATCH_LANES
+              experiments of one policy side by side, one lane each, with the state of every
+              lane kept in packed columns indexed by lane. Each step tries one placement in
+              every lane with pending tasks and runs a task in every lane whose placement
+              failed, picking blocks and ready tasks with branch free loops across the
+              lanes, so small memory layouts run several replications per step.
+
+* initRing, pushRing, popRing - Bounded lock-free ring of batch pointers. Any amount of
+              threads push and pop, each cell has a sequence number that says whose turn it
+              is, so neither side takes a lock. A full ring makes pushes wait, an empty one pops.
+
+* waitRing, wakeRing - Put a thread that has to wait on a ring to sleep on a condition
+              variable, and wake it once a cell changes hands.
+
+* runPipeline - Runs a round of experiments as three stages. A generator thread draws the
+              task streams of BATCH_LANES experiments at a time and queues a pointer to the
+              batch once per policy, the workers take a policy of a batch each, and the
+              calling thread adds up finished batches in experiment order. Drawing overlaps
+              simulating and the ring bounds how far ahead the generator runs.
+
+* resultKey, loadResults, saveResults - On disk cache of the results of each experiment,
+              one file per policy and configuration named by the hash of everything the results
+              depend on, so sweeps only simulate the experiments the cache does not have.
+***************************************************************************/
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <iostream>
+#include <time.h>
+#include <stdlib.h>
+#include <iomanip>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <vector>
+#include <queue>
+#include <deque>
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <chrono>
+
+using namespace std;
+
+#ifdef SIM_STATS
+#define STAT(...) __VA_ARGS__																								//Counter or timer statements, kept only in -DSIM_STATS builds
+#else
+#define STAT(...)
+#endif
+
+extern long long numTasks;																									//Tasks per experiment
+
+struct workload {																											//Structure to hold the task stream of one experiment, shared by every policy
+    once_flag generated;																									//Makes sure only the first policy to run generates the tasks
+    atomic<int> users{0};																									//Policies still to run on the task stream
+    vector<uint16_t> size;																									//Task sizes
+    vector<uint16_t> duration;																								//Task durations
+};
+
+struct taskState {																											//Structure to hold the task information one policy changes, one column per field
+    vector<int8_t> flag;																									//Task flag used to determine if a task has been processed or not
+    vector<int> blockLoc;																									//Location of task in memory
+    vector<int> spent;																										//Time spent to execute
+    vector<long long> received;																								//Time of when the task was received
+    vector<long long> started;																								//Time the task first ran, set when it is dispatched with no time spent
+};
+
+struct welford {																											//Structure to hold a running mean and variance
+    long long count = 0;																									//Samples added so far
+    double mean = 0;																										//Mean of the samples
+    double m2 = 0;																											//Sum of squared differences from the mean
+};
+
+const int HIST_SUB_BITS = 8;																								//Histogram buckets split each power of two into 128, under 0.8% error
+const int HIST_BUCKETS = (64 - HIST_SUB_BITS) * (1 << (HIST_SUB_BITS - 1)) + (1 << HIST_SUB_BITS);							//Buckets covering every 64 bit value
+const int RELATIVE_SCALE = 1000;																							//Relative turn around times are kept in thousandths
+
+struct histogram {																											//Structure to hold a log-linear histogram of values, fixed size and mergeable
+    uint64_t counts[HIST_BUCKETS] = {};																						//Values in each bucket
+    uint64_t total = 0;																										//Values recorded
+    int64_t max = 0;																										//Largest value recorded
+};
+
+struct latencySketch {																										//Structure to hold the turn around time distributions of one policy
+    struct histogram turnAround;																							//Turn around times
+    struct histogram relative;																								//Relative turn around times in thousandths
+};
+
+struct results{																												//Struct to store the results of one policy for one experiment
+    double ttat = 0;																										//Avg turn around time
+    double rtat = 0;																										//Avg relative turn around time
+    double ttatVar = 0;																										//Variance of the turn around time
+    double rtatVar = 0;																										//Variance of the relative turn around time
+};
+
+struct runStats {																											//Structure to hold the counters and phase timers of one run, filled in -DSIM_STATS builds
+    long long placeTries = 0;																								//Pending tasks tried for placement
+    long long placeFails = 0;																								//Placements that found no block
+    long long fragmented = 0;																								//Failed placements with enough free memory in total, only split over blocks
+    long long forcedDispatches = 0;																							//Dispatches made because the next pending task did not fit
+    long long preemptions = 0;																								//Running tasks srt took the processor from
+    long long requeues = 0;																									//Quantum expiries that put a task back in a queue
+    long long demotions = 0;																								//Tasks mlfq moved a level down
+    long long collapsedQuanta = 0;																							//Round robin quanta run as one event for a task alone in memory
+    long long compactions = 0;																								//Times the holes were slid together
+    long long moved = 0;																									//Units of memory the compactions moved
+    long long events = 0;																									//Events popped off the event queue
+    int peakPending = 0;																									//Most tasks waiting for memory at once
+    int peakResident = 0;																									//Most tasks in memory at once
+    long long freeMemory = 0;																								//Free memory over all blocks
+    double placeNs = 0;																										//Time spent placing tasks
+    double selectNs = 0;																									//Time spent picking the next task to run
+    double eventNs = 0;																										//Time spent dispatching and applying events
+};
+
+enum policy { FCFS_POLICY, RR_POLICY, SPN_POLICY, SRT_POLICY, HRRN_POLICY, MLFQ_POLICY, POLICIES };							//Scheduling policies run by each experiment
+
+const int MLFQ_LEVELS = 4;																									//Feedback queues of mlfq, level l runs a task for quantum * 2^l
+
+struct rngStream {																											//Structure to hold a random number stream
+    uint64_t s[4];																											//xoshiro256** state
+};
+
+struct normalSource {																										//Structure to hold a stream of normal random integers
+    struct rngStream rng;																									//Stream the uniform values are drawn from
+    int loops = 4;																											//Uniform values summed per value
+    int ulimit = 4;																											//Max of each uniform value
+    uint64_t word = 0;																										//Random bits not used yet
+    int left = 0;																											//Uniform values left in word
+};
+
+const char TRACE_MAGIC[8] = {'S', 'C', 'H', 'T', 'R', 'A', 'C', 'E'};														//First bytes of a binary trace file
+const uint32_t TRACE_VERSION = 1;																							//Version of the trace format
+
+struct traceHeader {																										//Structure at the start of a binary trace file, native byte order
+    char magic[8];																											//TRACE_MAGIC
+    uint32_t version;																										//TRACE_VERSION
+    uint32_t recordSize;																									//Bytes per record
+    uint64_t count;																											//Records in the file
+    uint32_t maxSize;																										//Largest task size in the file
+    uint32_t maxDuration;																									//Largest service time in the file
+};
+
+struct traceRecord {																										//Structure to hold one task of a binary trace, records are sorted by arrival
+    uint64_t arrival;																										//Time the task arrives
+    uint32_t size;																											//Memory size of the task
+    uint32_t duration;																										//Service time of the task
+};
+
+struct traceFile {																											//Structure to hold a binary trace file mapped into memory
+    int fd = -1;																											//Open file
+    size_t bytes = 0;																										//Length of the mapping
+    void *map = NULL;																										//Start of the mapping
+    const struct traceHeader *header = NULL;																				//Header at the start of the mapping
+    const struct traceRecord *records = NULL;																				//Records right after the header
+};
+
+const char TASKS_MAGIC[8] = {'S', 'C', 'H', 'T', 'A', 'S', 'K', 'S'};														//First bytes of a per task output file
+const uint32_t TASKS_VERSION = 2;																							//Version of the per task output format
+const int TASK_CHUNK = 65536;																								//Rows a worker buffers before writing them out
+
+struct tasksHeader {																										//Structure at the start of a per task output file, native byte order
+    char magic[8];																											//TASKS_MAGIC
+    uint32_t version;																										//TASKS_VERSION
+    uint32_t columns;																										//Columns in every chunk
+};
+
+struct taskSink {																											//Structure to hold the per task output file shared by all workers
+    FILE *file = NULL;																										//Open output file
+    mutex lock;																												//Keeps the chunks of different workers apart
+    long long rows = 0;																										//Rows written so far
+    bool failed = false;																									//A write failed
+};
+
+struct taskColumns {																										//Structure to hold the rows one worker buffers, written as a chunk of columns
+    struct taskSink *sink = NULL;																							//File the chunks go to
+    int policy = 0;																											//Policy of the current run
+    int experiment = 0;																										//Experiment of the current run
+    vector<uint8_t> policyCol;																								//Policy of each row
+    vector<uint32_t> experimentCol;																							//Experiment of each row
+    vector<int64_t> taskCol;																								//Position of the task in the task stream
+    vector<int32_t> blockCol;																								//Memory block the task was placed in
+    vector<int64_t> startCol;																								//Time the task first ran
+    vector<int64_t> finishCol;																								//Time the task finished
+    vector<int64_t> turnAroundCol;																							//Turn around time
+    vector<double> relativeCol;																								//Relative turn around time
+};
+
+const char CHECKPOINT_MAGIC[8] = {'S', 'C', 'H', 'C', 'K', 'P', 'T', '1'};													//First bytes of a checkpoint file
+const uint32_t CHECKPOINT_VERSION = 1;																						//Version of the checkpoint format
+
+struct runTotals {																											//Structure to hold what main has added up over the finished experiments
+    long long done = 0;																										//Experiments finished, the next one to run
+    double ta[POLICIES] = {0};																								//Sum of the avg turn around times in experiment order
+    double rta[POLICIES] = {0};																								//Sum of the avg relative turn around times in experiment order
+    struct welford means[POLICIES];																							//Avg turn around time of each experiment
+    struct welford diffs[POLICIES][POLICIES];																				//Difference between the avgs of two policies on the same experiment
+    struct latencySketch tails[POLICIES];																					//Sketches of every worker added up
+};
+
+struct checkpointHeader {																									//Structure at the start of a checkpoint file, native byte order, followed by a runTotals
+    char magic[8];																											//CHECKPOINT_MAGIC
+    uint32_t version;																										//CHECKPOINT_VERSION
+    uint32_t bytes;																											//Size of the runTotals that follows
+    uint64_t setup;																											//Hash of the settings of the run, a checkpoint of other settings is refused
+};
+
+const char CACHE_MAGIC[8] = {'S', 'C', 'H', 'C', 'A', 'C', 'H', 'E'};														//First bytes of a result cache file
+const uint32_t CACHE_VERSION = 2;																							//Bump when a change to the engine changes the results, so old cache files are missed
+
+struct cacheHeader {																										//Structure at the start of a result cache file, native byte order, followed by count results
+    char magic[8];																											//CACHE_MAGIC
+    uint32_t version;																										//CACHE_VERSION
+    uint32_t count;																											//Experiments 0 to count-1 held in the file
+    uint64_t key;																											//Key of the results, also the file name
+};
+
+struct taskSource {																											//Structure to hold where a run gets its tasks from
+    const struct workload *work = NULL;																						//Task stream generated up front, NULL when streaming
+    struct normalSource gen;																								//Draws the tasks one at a time when streaming
+    const struct traceRecord *trace = NULL;																					//Records of a mapped trace to replay instead, NULL otherwise
+    long long total = 0;																									//Tasks in the task stream
+    int window = 0;																											//Most tasks waiting for memory at once when streaming
+};
+
+struct workQueue {																											//Structure to hold the jobs owned by one worker thread
+    mutex lock;
+    deque<int> jobs;
+};
+
+enum fitType { FIRST_FIT, NEXT_FIT, BEST_FIT, WORST_FIT };																	//Placement algorithms used to pick a memory block
+
+enum memoryModel { FIXED_BLOCKS, FREE_LIST, BUDDY_SYSTEM };																	//Fixed blocks tasks share, holes between tasks at real addresses, or buddy blocks
+
+const int MAX_ADDRESSES = 1 << 24;																							//Largest memory of the holes and buddy models
+const int FITS = 4;																											//Placement algorithms, a placement is FITS * model + fit
+
+struct memoryMap {																											//Structure to hold the memory blocks and the index over their free space
+    int model = FIXED_BLOCKS;																								//Memory model
+    int m = 0;																												//The amount of blocks in memory, or of addresses for holes and buddies
+    int fit = FIRST_FIT;																									//Placement algorithm
+    int nextBlock = 0;																										//Block the next fit search starts from
+    int leaves = 1;																											//Leaves in the segment tree, m rounded up to a power of two
+    int freeSpace = 0;																										//Free memory over all blocks
+    int compactCost = -1;																									//Time units per unit of memory a compaction moves, -1 never compacts
+    vector<int> memBlocks;																									//Free space left in each block
+    vector<int> tree;																										//Segment tree of the most free space in each range of blocks, or of the longest hole starting in each range of addresses
+    set<pair<int, int>> bySize;																								//Blocks ordered by free space then block, or holes by length then address, for best fit
+    vector<int> holeLen;																									//Length of the hole starting at each address, 0 if none does
+    vector<int> holeStart;																									//Start of the hole ending at each address, only valid at the last address of a hole
+    vector<int> owner;																										//Task placed at each address, only valid where a task starts
+    int orders = 0;																											//Buddy blocks are 2^0 to 2^orders long
+    uint64_t freeOrders = 0;																								//Bit k set while a block of order k is free
+    vector<int> freeHead;																									//First free buddy block of each order, -1 when there is none
+    vector<int> nextFree;																									//Next free block of the same order after the one starting at each address
+    vector<int> prevFree;																									//Free block of the same order before it, -1 for the first
+    vector<int8_t> freeOrder;																								//Order of the free buddy block starting at each address, -1 if none does
+};
+
+struct simConfig {																											//Structure to hold the settings of a run
+    vector<int> blocks;																										//Size of each memory block, or the parts of one memory for holes and buddies
+    int fit = FIRST_FIT;																									//Placement algorithm
+    int model = FIXED_BLOCKS;																								//Memory model
+    int compactCost = -1;																									//Time units per unit of memory a compaction moves, -1 never compacts
+    int quantum = 1;																										//Round robin quantum
+    int window = 0;																											//Most tasks waiting for memory at once, 0 to generate the whole stream up front
+    long long tasks = 1000;																									//Tasks per experiment
+    int loops = 4;																											//Uniform values summed per task size or duration
+    int ulimit = 4;																											//Max of each uniform value
+    const struct traceFile *trace = NULL;																					//Trace to replay instead of generating experiments, NULL otherwise
+    struct taskSink *sink = NULL;																							//Where every finished task is written, NULL to only keep the avgs
+    FILE *stats = NULL;																										//Where the counters of every run are written in -DSIM_STATS builds, NULL for none
+};
+
+enum eventType { TASK_COMPLETE, QUANTUM_EXPIRE, LEVEL_EXPIRE };																//Events that can happen to a running task
+
+struct simEvent {																											//Structure to hold a scheduled event
+    long long time;																											//Time the event happens
+    long seq;																												//Order the event was scheduled in, breaks ties in time
+    int type;																												//Type of event
+    int task;																												//Task the event belongs to
+    int ran;																												//Time units the task runs for before the event
+};
+
+struct laterEvent {																											//Orders the event queue so the earliest event is on top
+    bool operator()(const struct simEvent &a, const struct simEvent &b) const {
+        if (a.time != b.time)
+            return a.time > b.time;
+        return a.seq > b.seq;
+    }
+};
+
+enum readyOrder { BY_RECEIVED, BY_DURATION, BY_REMAINING, ROUND_ROBIN, BY_RESPONSE_RATIO, FEEDBACK };						//Orders the ready queue can keep tasks in
+
+struct taskFifo {																											//Structure to hold a queue of tasks linked through simEngine::link
+    int head = -1;																											//First task, -1 when empty
+    int tail = -1;																											//Last task
+    int mark = -1;																											//Last task received before the tail was, -1 if none is, kept by hrrn buckets only
+};
+
+struct readyTask {																											//Structure to hold a task waiting in the ready queue
+    long long key;																											//Received time, duration or remaining time, depending on the order
+    long long id;																											//Position of the task in the task stream
+    int task;																												//Task in memory
+};
+
+struct laterReady {																											//Orders the ready queue so the smallest key is on top, ties go to the earlier task
+    bool operator()(const struct readyTask &a, const struct readyTask &b) const {
+        if (a.key != b.key)
+            return a.key > b.key;
+        return a.id > b.id;
+    }
+};
+
+struct simEngine {																											//Structure to hold the state of a simulation run
+    const struct workload *work;																							//Tasks in the task stream
+    struct taskState *process;																								//Task information changed by the run
+    struct memoryMap *mem;																									//Memory blocks
+    struct normalSource *gen = NULL;																						//Draws tasks on demand when streaming, NULL otherwise
+    const struct traceRecord *trace = NULL;																					//Trace the tasks are read from on demand, NULL otherwise
+    bool streaming = false;																									//Tasks come in one at a time and live in reused slots
+    struct taskColumns *out = NULL;																							//Rows of finished tasks are added here, NULL when not writing them
+    struct latencySketch *sketch = NULL;																					//Turn around time distributions finished tasks are added to, NULL for none
+    struct workload streamed;																								//Tasks drawn so far that are still needed when streaming
+    vector<long long> slotId;																								//Position in the task stream of the task in each slot when streaming
+    vector<int> freeSlots;																									//Slots of finished tasks that can be reused when streaming
+    long long total = 0;																									//Tasks in the task stream
+    long long generated = 0;																								//Tasks taken from the task stream so far
+    int window = 0;																											//Most tasks waiting to be placed at once
+    int quantum = 1;																										//Round robin quantum
+    long long clock = 0;																									//Current simulated time
+    int pending = 0;																										//Tasks waiting to be placed into memory
+    int resident = 0;																										//Tasks currently in memory
+    int prevPending = 0;																									//Pending task before the next one to be placed
+    int tail = 0;																											//Last pending task in stream order
+    int failedPlacements = 0;																								//Placements that failed since memory last changed
+    struct welford turnAround;																								//Turn around time of the finished tasks
+    struct welford relative;																								//Relative turn around time of the finished tasks
+    long seq = 0;																											//Events scheduled so far
+    long long dispatches = 0;																								//Times a task was given the processor
+    vector<int> nextPending;																								//Circular list of pending tasks in stream order
+    vector<int> runQueue;																									//Circular round robin run queue
+    int runHead = 0;																										//Front of the run queue
+    int runCount = 0;																										//Tasks in the run queue
+    vector<struct simEvent> events;																							//Time ordered event queue, a heap kept by laterEvent
+    vector<struct readyTask> ready;																							//Tasks in memory waiting to run, a heap kept by laterReady
+    vector<int> readyPos;																									//Place of each task in the ready heap for srt, -1 when not in it
+    int running = -1;																										//Task srt ran last if it is still unfinished, -1 otherwise
+    vector<int> link;																										//Next task in the same hrrn bucket or mlfq level, -1 for the last
+    vector<int8_t> level;																									//Feedback queue of each task for mlfq
+    vector<struct taskFifo> buckets;																						//Tasks in memory waiting to run for hrrn, one queue per service time
+    vector<int> activeBuckets;																								//Service times whose bucket is not empty
+    vector<double> activeReceived;																							//Received time of the front task of each active bucket, packed for maxRatio
+    vector<double> activeRate;																								//One over the service time of each active bucket, packed for maxRatio
+    struct taskFifo levels[MLFQ_LEVELS];																					//Tasks in memory waiting to run for mlfq, one queue per level
+    struct runStats stats;																									//Counters and timers of the run, only kept up in -DSIM_STATS builds
+};
+
+struct runArena {																											//Structure to hold the buffers one worker thread reuses for every run
+    struct memoryMap mem;																									//Memory blocks of the current run
+    struct taskState process;																								//Task information changed by the current run
+    struct simEngine sim;																									//Engine of the current run
+    struct taskColumns out;																									//Finished tasks not written out yet
+    struct latencySketch sketch[POLICIES];																					//Turn around time distributions of every run of each policy on this worker
+    vector<int> batchNext;																									//Pending lists of the lanes of a lock-step batch, lane l's from l * tasks
+};
+
+const int BATCH_LANES = 4;																									//Experiments a lock-step batch runs side by side
+const int BATCH_BLOCKS = 8;																									//Most memory blocks a batch can model
+const int BATCH_SLOTS = 64;																									//Most tasks in memory in one lane of a batch, one bit each in a 64 bit mask
+const int PIPELINE_DEPTH = 4;																								//Batches per worker the generator may run ahead
+
+struct workBatch {																											//Structure to hold BATCH_LANES experiments that go through the pipeline together
+    int first = 0;																											//Experiment number of the first lane
+    int lanes = 0;																											//Experiments in the batch
+    struct workload *works = NULL;																							//Task streams of the lanes, NULL when streaming
+    struct results *res = NULL;																								//Result slots, POLICIES per lane
+    atomic<int> nextPolicy{0};																								//Policy the next worker to take the batch runs
+    atomic<int> finished{0};																								//Policies done with every lane
+};
+
+struct ringCell {																											//Structure to hold one cell of a batchRing
+    atomic<size_t> seq{0};																									//Position the cell is free to push at, or that position + 1 once it holds a batch
+    struct workBatch *batch = NULL;
+};
+
+struct batchRing {																											//Structure to hold a bounded lock-free queue of batch pointers
+    vector<struct ringCell> cells;																							//A power of two of them
+    size_t mask = 0;
+    alignas(64) atomic<size_t> head{0};																						//Next position to push at
+    alignas(64) atomic<size_t> tail{0};																						//Next position to pop from
+    alignas(64) atomic<int> sleepers{0};																					//Threads asleep in waitRing
+    mutex lock;																												//Guards going to sleep against being woken
+    condition_variable moved;																								//Signalled when a cell is pushed or popped while a thread sleeps
+};
+
+struct columnPool {																											//Structure to hold task stream columns that are free to reuse
+    mutex lock;																												//Guards spare
+    vector<vector<uint16_t>> spare;																							//Columns of finished experiments
+};
+
+extern struct columnPool spareColumns;																						//Columns handed from finished experiments to new ones
+
+uint64_t splitMix(uint64_t &x);
+void seedStream(struct rngStream &rng, uint64_t seed, uint64_t stream);
+int uniform(struct rngStream &rng, int lo, int hi);
+int normal(struct rngStream &rng, int loops, int ulimit);
+void takeColumn(vector<uint16_t> &column);
+void giveColumn(vector<uint16_t> &column);
+void setTasks(struct workload &work, struct normalSource &src, long long count);
+void setBlocks(struct memoryMap &mem, const vector<int> &blocks, int fit);
+void setHoles(struct memoryMap &mem, int size, int fit);
+void setBuddies(struct memoryMap &mem, int size);
+void setMemory(struct memoryMap &mem, const struct simConfig &config);
+void takeHole(struct memoryMap &mem, int j, int size);
+void giveHole(struct memoryMap &mem, int j, int size);
+void pushBuddy(struct memoryMap &mem, int j, int k);
+void dropBuddy(struct memoryMap &mem, int j);
+void takeBuddy(struct memoryMap &mem, int j, int size);
+void giveBuddy(struct memoryMap &mem, int j, int size);
+void compactMemory(struct simEngine &sim);
+int searchFit(const struct memoryMap &mem, int node, int nl, int nr, int lo, int size);
+bool parseBlocks(const char *list, vector<int> &blocks);
+double variance(const struct welford &stats);
+double tCritical(long long df);
+double ciHalfWidth(const struct welford &stats);
+void storeResults(const struct simEngine &sim, struct results &res);
+int newSlot(struct simEngine &sim);
+void addPending(struct simEngine &sim);
+void initSim(struct simEngine &sim, struct memoryMap &mem, struct taskSource &source, struct taskState &process);
+void admitArrivals(struct simEngine &sim);
+void waitArrival(struct simEngine &sim);
+bool openTrace(const char *path, struct traceFile &trace);
+void mergeHistogram(struct histogram &into, const struct histogram &from);
+int64_t valueAtQuantile(const struct histogram &hist, double q);
+bool openSink(const char *path, struct taskSink &sink);
+void recordTask(struct simEngine &sim, int loc, long long turnAround, double relative);
+void flushColumns(struct taskColumns &cols);
+bool closeSink(struct taskSink &sink);
+void closeTrace(struct traceFile &trace);
+void pushRun(struct simEngine &sim, int loc);
+int popRun(struct simEngine &sim);
+void skipPending(struct simEngine &sim, int steps);
+void srt(struct runArena &arena, struct taskSource &source, struct results &res);
+void rr(struct runArena &arena, struct taskSource &source, int q, struct results &res);
+void spn(struct runArena &arena, struct taskSource &source, struct results &res);
+void fcfs(struct runArena &arena, struct taskSource &source, struct results &res);
+void hrrn(struct runArena &arena, struct taskSource &source, struct results &res);
+double maxRatio(const double *received, const double *rate, int n, double clock);
+void writeStats(FILE *out, int p, int k, const struct simEngine &sim, double genNs);
+uint64_t hashBytes(uint64_t hash, const void *data, size_t bytes);
+bool saveCheckpoint(const char *path, uint64_t setup, const struct runTotals &totals);
+int loadCheckpoint(const char *path, uint64_t setup, struct runTotals &totals);
+bool trimStats(const char *path, int done);
+uint64_t resultKey(const struct simConfig &config, int p, uint64_t seed);
+int loadResults(const char *dir, uint64_t key, vector<struct results> &cached);
+bool saveResults(const char *dir, uint64_t key, const vector<struct results> &cached);
+void mlfq(struct runArena &arena, struct taskSource &source, int q, struct results &res);
+bool takeJob(vector<struct workQueue> &queues, int self, int &job);
+void runJobs(int jobs, int threads, const function<void(int, int)> &work);
+void runPolicy(int p, struct runArena &arena, struct taskSource &source, const struct simConfig &config, struct results &res);
+void runExperiment(uint64_t seed, int k, struct workload &work, int p, const struct simConfig &config, struct runArena &arena, struct results &res);
+void generateWork(uint64_t seed, int k, struct workload &work, const struct simConfig &config, double &genNs);
+bool canBatch(int p, const struct simConfig &config);
+void initRing(struct batchRing &ring, size_t size);
+void pushRing(struct batchRing &ring, struct workBatch *batch);
+struct workBatch *popRing(struct batchRing &ring);
+void waitRing(struct batchRing &ring, const struct ringCell &cell, size_t seq);
+void wakeRing(struct batchRing &ring);
+void runPipeline(vector<struct workBatch> &batches, int threads, uint64_t seed, const struct simConfig &config, vector<struct runArena> &arenas,
+                 const function<void(struct workBatch &)> &aggregate);
+void runBatch(uint64_t seed, int k, int lanes, struct workload *works, int p, const struct simConfig &config, struct runArena &arena,
+              struct results *res, int stride);
+
+/***************************************************************************
+* void addSample(struct welford &stats, double x)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a sample to a running mean and variance using Welford's
+               method, so finished tasks do not have to be kept around.
+* Parameters:
+* stats I/P struct welford - The running stats
+* x     I/P double - The sample
+***************************************************************************/
+
+inline void addSample(struct welford &stats, double x)
+{
+    stats.count++;
+    double delta = x - stats.mean;
+    stats.mean += delta / stats.count;
+    stats.m2 += delta * (x - stats.mean);
+}
+
+/***************************************************************************
+* double elapsedNs(chrono::steady_clock::time_point start)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the time since start, for the phase timers.
+* Parameters:
+* start     I/P chrono::steady_clock::time_point - When the phase started
+* elapsedNs O/P double - Nanoseconds since start
+***************************************************************************/
+
+inline double elapsedNs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+}
+
+/***************************************************************************
+* int bucketOf(uint64_t v)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Finds the histogram bucket of a value. Values below 256 get a
+               bucket each, above that every power of two is split into 128
+               buckets of equal width.
+* Parameters:
+* v         I/P uint64_t - The value
+* bucketOf  O/P int - The bucket
+***************************************************************************/
+
+inline int bucketOf(uint64_t v)
+{
+    if (v < (1u << HIST_SUB_BITS))
+        return v;
+    int shift = 63 - __builtin_clzll(v) - HIST_SUB_BITS + 1;
+    return shift * (1 << (HIST_SUB_BITS - 1)) + (int)(v >> shift);
+}
+
+/***************************************************************************
+* void recordValue(struct histogram &hist, int64_t v)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a value to a histogram. Negative values count as 0.
+* Parameters:
+* hist  I/P struct histogram - The histogram
+* v     I/P int64_t - The value
+***************************************************************************/
+
+inline void recordValue(struct histogram &hist, int64_t v)
+{
+    if (v < 0)
+        v = 0;
+    hist.counts[bucketOf(v)]++;
+    hist.total++;
+    if (v > hist.max)
+        hist.max = v;
+}
+
+/***************************************************************************
+* void recordValues(struct histogram &hist, int64_t v, int times)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a value to a histogram a number of times, without branches
+               so lanes of a batch that have nothing to add can pass 0 times.
+* Parameters:
+* hist  I/P struct histogram - The histogram
+* v     I/P int64_t - The value, not negative
+* times I/P int - Times to add it
+***************************************************************************/
+
+inline void recordValues(struct histogram &hist, int64_t v, int times)
+{
+    hist.counts[bucketOf(v)] += times;
+    hist.total += times;
+    hist.max = max(hist.max, v);
+}
+
+/***************************************************************************
+* int placementOf(const struct memoryMap &mem)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the placement the memory was set up for, FITS * model +
+               fit. Buddy systems have no fit of their own and are all one.
+* Parameters:
+* mem           I/P struct memoryMap - The memory
+* placementOf   O/P int - The placement, the FIT template parameter that runs on it
+***************************************************************************/
+
+inline int placementOf(const struct memoryMap &mem)
+{
+    return mem.model == BUDDY_SYSTEM ? BUDDY_SYSTEM * FITS : mem.model * FITS + mem.fit;
+}
+
+/***************************************************************************
+* void setLeaf(struct memoryMap &mem, int j, int value)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Sets the free space of leaf j of the segment tree and walks up
+               to the root keeping the maximum of every range.
+* Parameters:
+* mem       I/P struct memoryMap - The memory holding the tree
+* j         I/P int - The block, or the address for holes
+* value     I/P int - Its free space, or the length of the hole starting there
+***************************************************************************/
+
+inline void setLeaf(struct memoryMap &mem, int j, int value)
+{
+    int node = mem.leaves + j;
+    mem.tree[node] = value;
+    for (node /= 2; node >= 1; node /= 2){																					//Walk up to the root
+        mem.tree[node] = max(mem.tree[2 * node], mem.tree[2 * node + 1]);
+    }
+}
+
+/***************************************************************************
+* int buddyOrder(int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Gives the order of the smallest buddy block that holds a task.
+* Parameters:
+* size          I/P int - Size of the task, at least 1
+* buddyOrder    O/P int - k such that 2^k is the first power of two >= size
+***************************************************************************/
+
+inline int buddyOrder(int size)
+{
+    return size > 1 ? 32 - __builtin_clz(size - 1) : 0;
+}
+
+/***************************************************************************
+* int findBuddy(const struct memoryMap &mem, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Finds the free buddy block of the lowest order that holds a
+               task, the first one on its order's free list.
+* Parameters:
+* mem       I/P struct memoryMap - The buddy system
+* size      I/P int - Size of the task
+* findBuddy O/P int - Address of the block, -1 if no free block is big enough
+***************************************************************************/
+
+inline int findBuddy(const struct memoryMap &mem, int size)
+{
+    int need = buddyOrder(size);
+    uint64_t bigEnough = need <= mem.orders ? mem.freeOrders >> need : 0;
+    if (bigEnough == 0)
+        return -1;
+    return mem.freeHead[need + __builtin_ctzll(bigEnough)];
+}
+
+/***************************************************************************
+* template <int FIT> void resizeBlock(struct memoryMap &mem, int j, int change)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Changes the free space of a block and updates the index. With
+               holes or buddies j is an address, a negative change places a
+               task there and a positive one frees the task placed there.
+* Parameters:
+* mem       I/P struct memoryMap - The memory holding the block
+* j         I/P int - The block
+* change    I/P int - Amount of free space added, negative when allocating
+* FIT       I/P int - Placement the memory uses, see placementOf
+***************************************************************************/
+
+template <int FIT>
+void resizeBlock(struct memoryMap &mem, int j, int change)
+{
+    if constexpr (FIT / FITS == FREE_LIST){
+        if (change < 0)
+            takeHole(mem, j, -change);
+        else
+            giveHole(mem, j, change);
+    }
+    else if constexpr (FIT / FITS == BUDDY_SYSTEM){
+        if (change < 0)
+            takeBuddy(mem, j, -change);
+        else
+            giveBuddy(mem, j, change);
+    }
+    else {
+        if constexpr (FIT == BEST_FIT){																						//Move the block's node to its new place without reallocating it
+            set<pair<int, int>>::node_type node = mem.bySize.extract({mem.memBlocks[j], j});
+            node.value().first += change;
+            mem.bySize.insert(move(node));
+        }
+        mem.memBlocks[j] += change;
+        mem.freeSpace += change;
+        setLeaf(mem, j, mem.memBlocks[j]);
+    }
+}
+
+/***************************************************************************
+* template <int FIT> int findBlock(struct memoryMap &mem, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Picks the block to place a task in using the memory's placement
+               algorithm. First fit takes the first block that can hold the task,
+               next fit the first one from where the last task was placed, best
+               fit the one with the least free space that can hold it and worst
+               fit the one with the most free space. Ties go to the first block.
+               Holes are searched the same way with one leaf per address, so
+               the block found is the start of a hole, and a buddy system hands
+               out the smallest free block that holds the task.
+* Parameters:
+* mem       I/P struct memoryMap - The memory to search
+* size      I/P int - Size of the task
+* FIT       I/P int - Placement to use, see placementOf
+* findBlock O/P int - The block found, -1 if the task does not fit
+***************************************************************************/
+
+template <int FIT>
+int findBlock(struct memoryMap &mem, int size)
+{
+    if constexpr (FIT / FITS == BUDDY_SYSTEM){
+        return findBuddy(mem, size);
+    }
+    int j = -1;
+    if constexpr (FIT % FITS == FIRST_FIT){
+        j = searchFit(mem, 1, 0, mem.leaves - 1, 0, size);
+    }
+    else if constexpr (FIT % FITS == NEXT_FIT){
+        j = searchFit(mem, 1, 0, mem.leaves - 1, mem.nextBlock, size);
+        if (j == -1){																										//Wrap around to the first block
+            j = searchFit(mem, 1, 0, mem.leaves - 1, 0, size);
+        }
+        if (j != -1){
+            mem.nextBlock = j;
+        }
+    }
+    else if constexpr (FIT % FITS == BEST_FIT){
+        set<pair<int, int>>::iterator it = mem.bySize.lower_bound({size, -1});
+        if (it != mem.bySize.end()){
+            j = it->second;
+        }
+    }
+    else {
+        if (mem.tree[1] >= size){
+            j = searchFit(mem, 1, 0, mem.leaves - 1, 0, mem.tree[1]);
+        }
+    }
+    return j;
+}
+
+/***************************************************************************
+* int popReady(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the task at the top of the ready queue, the task in memory
+               with the smallest received time for fcfs or the shortest service
+               time for spn.
+* Parameters:
+* sim       I/P struct simEngine - The engine holding the run state
+* popReady  O/P int - The task found
+***************************************************************************/
+
+inline int popReady(struct simEngine &sim){
+    pop_heap(sim.ready.begin(), sim.ready.end(), laterReady());
+    int loc = sim.ready.back().task;
+    sim.ready.pop_back();
+    return loc;
+}
+
+/***************************************************************************
+* void siftReady(struct simEngine &sim, int k)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Moves the entry at place k of the ready heap up or down until
+               the heap is in order again, keeping readyPos up to date.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* k     I/P int - Place of the entry that moved
+***************************************************************************/
+
+inline void siftReady(struct simEngine &sim, int k){
+    struct readyTask moved = sim.ready[k];
+    int n = sim.ready.size();
+    while (k > 0 && laterReady()(sim.ready[(k - 1) / 2], moved)){															//Up while the parent is later
+        sim.ready[k] = sim.ready[(k - 1) / 2];
+        sim.readyPos[sim.ready[k].task] = k;
+        k = (k - 1) / 2;
+    }
+    while (2 * k + 1 < n){																									//Down while a child is earlier
+        int child = 2 * k + 1;
+        if (child + 1 < n && laterReady()(sim.ready[child], sim.ready[child + 1]))
+            child++;
+        if (!laterReady()(moved, sim.ready[child]))
+            break;
+        sim.ready[k] = sim.ready[child];
+        sim.readyPos[sim.ready[k].task] = k;
+        k = child;
+    }
+    sim.ready[k] = moved;
+    sim.readyPos[moved.task] = k;
+}
+
+/***************************************************************************
+* void pushReady(struct simEngine &sim, const struct readyTask &entry)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a task to the ready heap of srt in O(log r).
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* entry I/P struct readyTask - The task and its remaining time
+***************************************************************************/
+
+inline void pushReady(struct simEngine &sim, const struct readyTask &entry){
+    sim.ready.push_back(entry);
+    siftReady(sim, sim.ready.size() - 1);
+}
+
+/***************************************************************************
+* void decreaseKey(struct simEngine &sim, int loc, long long key)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Lowers the remaining time of a task in the ready heap of srt
+               where it is, in O(log r).
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* loc   I/P int - The task
+* key   I/P long long - Its new remaining time
+***************************************************************************/
+
+inline void decreaseKey(struct simEngine &sim, int loc, long long key){
+    int k = sim.readyPos[loc];
+    sim.ready[k].key = key;
+    siftReady(sim, k);
+}
+
+/***************************************************************************
+* void pushFifo(struct simEngine &sim, struct taskFifo &fifo, int loc)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Adds a task to the back of a queue.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* fifo  I/P struct taskFifo - The queue
+* loc   I/P int - The task
+***************************************************************************/
+
+inline void pushFifo(struct simEngine &sim, struct taskFifo &fifo, int loc){
+    sim.link[loc] = -1;
+    if (fifo.head == -1)
+        fifo.head = loc;
+    else
+        sim.link[fifo.tail] = loc;
+    fifo.tail = loc;
+}
+
+/***************************************************************************
+* int popFifo(struct simEngine &sim, struct taskFifo &fifo)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the task at the front of a queue that is not empty.
+* Parameters:
+* sim       I/P struct simEngine - The engine holding the run state
+* fifo      I/P struct taskFifo - The queue
+* popFifo   O/P int - The task found
+***************************************************************************/
+
+inline int popFifo(struct simEngine &sim, struct taskFifo &fifo){
+    int loc = fifo.head;
+    fifo.head = sim.link[loc];
+    return loc;
+}
+
+/***************************************************************************
+* void pushBucket(struct simEngine &sim, int loc)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Queues a task for hrrn behind the tasks with the same service time.
+               Tasks are received in clock order, so a bucket is sorted by
+               received time. Tasks placed at the same time are kept in stream
+               order, the way the ready heaps break ties, so the front of a
+               bucket does not depend on the order placement found them in.
+               Only the tasks received at the time of the tail are walked.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* loc   I/P int - The task
+***************************************************************************/
+
+inline void pushBucket(struct simEngine &sim, int loc){
+    int d = sim.work->duration[loc];
+    if (d >= (int)sim.buckets.size()){																						//First time this service time is seen by the engine
+        sim.buckets.resize(d + 1);
+    }
+    struct taskFifo &bucket = sim.buckets[d];
+    if (bucket.head == -1){
+        sim.activeBuckets.push_back(d);
+        sim.activeReceived.push_back(sim.process->received[loc]);
+        sim.activeRate.push_back(1.0 / d);
+        bucket.mark = -1;
+        pushFifo(sim, bucket, loc);
+        return;
+    }
+    if (sim.process->received[bucket.tail] != sim.process->received[loc]){													//Received after every task in the bucket
+        bucket.mark = bucket.tail;
+        pushFifo(sim, bucket, loc);
+        return;
+    }
+    long long id = sim.streaming ? sim.slotId[loc] : loc;
+    int prev = bucket.mark;
+    int next = prev == -1 ? bucket.head : sim.link[prev];
+    while (next != -1 && (sim.streaming ? sim.slotId[next] : next) < id){													//Past the tasks received at the same time earlier in the stream
+        prev = next;
+        next = sim.link[next];
+    }
+    if (next == -1){
+        pushFifo(sim, bucket, loc);
+        return;
+    }
+    sim.link[loc] = next;
+    if (prev == -1)
+        bucket.head = loc;
+    else
+        sim.link[prev] = loc;
+}
+
+/***************************************************************************
+* int popHighestRatio(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the task with the highest response ratio, (wait + service)
+               / service. The front of a bucket waited longest of all tasks with
+               its service time, so only the fronts are compared. maxRatio finds
+               the largest wait / service time in doubles, multiplying by one
+               over the service time, which is off by at most two roundings. The
+               fronts within that of it are then compared exactly by cross
+               multiplying waits and service times. Ties go to the earlier task
+               in the stream, which pushBucket keeps at the front of its bucket.
+* Parameters:
+* sim               I/P struct simEngine - The engine holding the run state
+* popHighestRatio   O/P int - The task found
+***************************************************************************/
+
+inline int popHighestRatio(struct simEngine &sim){
+    int n = sim.activeBuckets.size();
+    double clock = sim.clock;
+    double top = maxRatio(sim.activeReceived.data(), sim.activeRate.data(), n, clock);
+    double cutoff = top * (1 - 0x1p-50);																					//Waits are exact below 2^53, so only rounding separates a front from top
+    int best = -1, bestLoc = -1;
+    for (int b = 0; b < n; b++){
+        if ((clock - sim.activeReceived[b]) * sim.activeRate[b] < cutoff)													//Cannot have the highest ratio
+            continue;
+        int loc = sim.buckets[sim.activeBuckets[b]].head;
+        if (best == -1){
+            best = b;
+            bestLoc = loc;
+            continue;
+        }
+        long long wait = sim.clock - sim.process->received[loc], bestWait = sim.clock - sim.process->received[bestLoc];
+        long long higher = wait * sim.work->duration[bestLoc] - bestWait * sim.work->duration[loc];
+        if (higher > 0 || (higher == 0 && (sim.streaming ? sim.slotId[loc] < sim.slotId[bestLoc] : loc < bestLoc))){
+            best = b;
+            bestLoc = loc;
+        }
+    }
+    struct taskFifo &bucket = sim.buckets[sim.activeBuckets[best]];
+    popFifo(sim, bucket);
+    if (bucket.mark == bestLoc)																								//The tasks received at the time of the tail now start at the head
+        bucket.mark = -1;
+    if (bucket.head == -1){																									//Bucket emptied, drop it from the active list
+        sim.activeBuckets[best] = sim.activeBuckets.back();
+        sim.activeBuckets.pop_back();
+        sim.activeReceived[best] = sim.activeReceived.back();
+        sim.activeReceived.pop_back();
+        sim.activeRate[best] = sim.activeRate.back();
+        sim.activeRate.pop_back();
+    }
+    else {
+        sim.activeReceived[best] = sim.process->received[bucket.head];
+    }
+    return bestLoc;
+}
+
+/***************************************************************************
+* int popFeedback(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Takes the task at the front of the highest mlfq level that has one.
+* Parameters:
+* sim           I/P struct simEngine - The engine holding the run state
+* popFeedback   O/P int - The task found
+***************************************************************************/
+
+inline int popFeedback(struct simEngine &sim){
+    int l = 0;
+    while (sim.levels[l].head == -1)
+        l++;
+    return popFifo(sim, sim.levels[l]);
+}
+
+/***************************************************************************
+* bool canAdmit(const struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tells if the next task of the task stream can join the pending
+               list now. There has to be room in the window, and a trace task
+               has to have arrived.
+* Parameters:
+* sim       I/P struct simEngine - The engine holding the run state
+* canAdmit  O/P bool - True if addPending can take the next task
+***************************************************************************/
+
+inline bool canAdmit(const struct simEngine &sim){
+    if (sim.generated >= sim.total || sim.pending >= sim.window)
+        return false;
+    return sim.trace == NULL || (long long)sim.trace[sim.generated].arrival <= sim.clock;
+}
+
+/***************************************************************************
+* template <int ORDER, int FIT> bool placeNext(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Tries to place the next pending task into memory using the memory's
+               placement algorithm. A placed task is unlinked from the pending list and
+               pushed onto the ready queue, or the back of the run queue for round
+               robin. Otherwise the task is skipped until the scan comes around
+               to it again. With holes and a compaction cost, a task that does
+               not fit into any hole but into all of them together has memory
+               compacted for it first, and the trace tasks that arrived while
+               memory was compacted join the pending list once it is placed.
+* Parameters:
+* sim       I/P struct simEngine - The engine holding the run state
+* ORDER     I/P int - Order of the ready queue, ROUND_ROBIN for the run queue
+* FIT       I/P int - Placement of the memory, see placementOf
+* placeNext O/P bool - True if the task was placed into memory
+***************************************************************************/
+
+template <int ORDER, int FIT>
+bool placeNext(struct simEngine &sim){
+    struct taskState &process = *sim.process;
+    int i = sim.nextPending[sim.prevPending];
+    int size = sim.work->size[i];
+    int j = findBlock<FIT>(*sim.mem, size);
+    bool compacted = false;
+    STAT(sim.stats.placeTries++;)
+    if constexpr (FIT / FITS == FREE_LIST){
+        if (j == -1 && sim.mem->compactCost >= 0 && sim.mem->freeSpace >= size){											//Only the holes together are big enough
+            compactMemory(sim);
+            compacted = true;
+            j = findBlock<FIT>(*sim.mem, size);
+        }
+    }
+    if (j != -1){																											//If allocation is possible
+        process.flag[i] = 1;																								//Change the process flag to 1 (representing allocated)
+        process.received[i] = sim.clock;																					//Set the process received time
+        resizeBlock<FIT>(*sim.mem, j, -size);																				//Reduce  block size
+        if constexpr (FIT / FITS == FREE_LIST){																				//Compaction finds the task by its address
+            sim.mem->owner[j] = i;
+        }
+        process.blockLoc[i] = j;																							//Update block location in the struct
+        sim.nextPending[sim.prevPending] = sim.nextPending[i];																//Unlink the task from the pending list
+        if (i == sim.tail){
+            sim.tail = sim.prevPending;
+        }
+        sim.pending--;
+        sim.resident++;
+        sim.failedPlacements = 0;
+        STAT(sim.stats.freeMemory -= size;
+             sim.stats.peakResident = max(sim.stats.peakResident, sim.resident);)
+        long long id = sim.streaming ? sim.slotId[i] : i;
+        if constexpr (ORDER == BY_RECEIVED){																				//Queue the task for fcfs
+            sim.ready.push_back({process.received[i], id, i});
+            push_heap(sim.ready.begin(), sim.ready.end(), laterReady());
+        }
+        else if constexpr (ORDER == BY_DURATION){																			//Queue the task for spn
+            sim.ready.push_back({sim.work->duration[i], id, i});
+            push_heap(sim.ready.begin(), sim.ready.end(), laterReady());
+        }
+        else if constexpr (ORDER == BY_REMAINING){																			//Queue the task for srt, a newcomer has all its time left
+            pushReady(sim, {sim.work->duration[i], id, i});
+        }
+        else if constexpr (ORDER == BY_RESPONSE_RATIO){																		//Queue the task for hrrn
+            pushBucket(sim, i);
+        }
+        else if constexpr (ORDER == FEEDBACK){																				//Newcomers start at the top level of mlfq
+            sim.level[i] = 0;
+            pushFifo(sim, sim.levels[0], i);
+        }
+        else {
+            pushRun(sim, i);
+        }
+        if (compacted && sim.trace){																						//The clock moved on while compacting, let in every task that arrived meanwhile
+            admitArrivals(sim);
+        }
+        else if (canAdmit(sim)){																							//Make room in the window for the next task
+            addPending(sim);
+        }
+        return true;
+    }
+    sim.prevPending = i;																									//Move on to the next pending task
+    sim.failedPlacements++;
+    STAT(sim.stats.placeFails++;
+         if (sim.stats.freeMemory >= size)
+             sim.stats.fragmented++;)
+    return false;
+}
+
+/***************************************************************************
+* template <int EVENT> void dispatch(struct simEngine &sim, int loc)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs a resident task from the current time. TASK_COMPLETE runs the
+               task until it finishes, QUANTUM_EXPIRE runs it for one quantum and
+               LEVEL_EXPIRE for the quantum of its mlfq level.
+               The matching event is pushed onto the event queue.
+               A task that is alone in memory while no pending task fits would
+               only be dispatched again and again, so its remaining quanta are
+               run as one event and the pending scan skips ahead to match, unless
+               trace tasks could still arrive while it runs.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* loc   I/P int - The task to run
+* EVENT I/P int - The event that ends the run
+***************************************************************************/
+
+template <int EVENT>
+void dispatch(struct simEngine &sim, int loc){
+    struct simEvent ev;
+    sim.dispatches++;
+    if (sim.process->spent[loc] == 0){																						//First time the task runs
+        sim.process->started[loc] = sim.clock;
+    }
+    ev.seq = sim.seq++;
+    ev.type = EVENT;
+    ev.task = loc;
+    int remaining = sim.work->duration[loc] - sim.process->spent[loc];
+    if constexpr (EVENT == TASK_COMPLETE){
+        ev.ran = remaining;
+    }
+    else if constexpr (EVENT == LEVEL_EXPIRE){
+        long long slice = (long long)sim.quantum << sim.level[loc];
+        ev.ran = remaining < slice ? remaining : slice;
+    }
+    else {
+        if (sim.runCount == 0 && sim.failedPlacements >= sim.pending && !(sim.trace && sim.generated < sim.total)){			//Nothing else can run until this task finishes
+            int quanta = (remaining + sim.quantum - 1) / sim.quantum;
+            skipPending(sim, quanta - 1);
+            STAT(sim.stats.collapsedQuanta += quanta - 1;)
+            ev.ran = remaining;
+        }
+        else {
+            ev.ran = remaining < sim.quantum ? remaining : sim.quantum;
+        }
+    }
+    ev.time = sim.clock + ev.ran;
+    sim.events.push_back(ev);
+    push_heap(sim.events.begin(), sim.events.end(), laterEvent());
+}
+
+/***************************************************************************
+* template <int FIT> void completeTask(struct simEngine &sim, int loc)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Marks a task as completed at the current time and frees its memory.
+               Its turn around and relative turn around time are added to the
+               running stats, the sketch and the output file if there are ones, and when
+               streaming its slot is freed for reuse.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* loc   I/P int - The task that finished
+* FIT   I/P int - Placement algorithm of the memory
+***************************************************************************/
+
+template <int FIT>
+void completeTask(struct simEngine &sim, int loc){
+    struct taskState &process = *sim.process;
+    process.flag[loc] = 2;																									//Mark task as completed
+    resizeBlock<FIT>(*sim.mem, process.blockLoc[loc], sim.work->size[loc]);													//Update the block
+    long long turnAround = sim.clock - process.received[loc];																//Calculate the turn around time
+    addSample(sim.turnAround, turnAround);
+    double relative = (double)turnAround / sim.work->duration[loc];															//Calculate the relative turn around time
+    addSample(sim.relative, relative);
+    if (sim.sketch){
+        recordValue(sim.sketch->turnAround, turnAround);
+        recordValue(sim.sketch->relative, llround(relative * RELATIVE_SCALE));
+    }
+    if (sim.out){																											//Keep the task's row for the output file
+        recordTask(sim, loc, turnAround, relative);
+    }
+    if (sim.streaming){
+        sim.freeSlots.push_back(loc);
+    }
+    sim.resident--;
+    sim.failedPlacements = 0;
+    STAT(sim.stats.freeMemory += sim.work->size[loc];)
+}
+
+/***************************************************************************
+* template <int EVENT, int FIT> void nextEvent(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Pops the earliest event off the event queue, advances the clock
+               to it and applies it. A task whose quantum expired goes to the
+               back of the run queue, or for mlfq one level down. When replaying
+               a trace the tasks that arrived by then join the pending list.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* EVENT I/P int - The event the policy ends runs with
+* FIT   I/P int - Placement algorithm of the memory
+***************************************************************************/
+
+template <int EVENT, int FIT>
+void nextEvent(struct simEngine &sim){
+    pop_heap(sim.events.begin(), sim.events.end(), laterEvent());
+    struct simEvent ev = sim.events.back();
+    sim.events.pop_back();
+    STAT(sim.stats.events++;)
+    sim.clock = ev.time;																									//Advance the clock to the event
+    sim.process->spent[ev.task] += ev.ran;																					//Increment time spent
+    if (sim.process->spent[ev.task] == sim.work->duration[ev.task]){
+        completeTask<FIT>(sim, ev.task);
+    }
+    else if constexpr (EVENT == LEVEL_EXPIRE){																				//Used up its level's quantum, one level down
+        if (sim.level[ev.task] < MLFQ_LEVELS - 1){
+            sim.level[ev.task]++;
+            STAT(sim.stats.demotions++;)
+        }
+        STAT(sim.stats.requeues++;)
+        pushFifo(sim, sim.levels[sim.level[ev.task]], ev.task);
+    }
+    else {
+        pushRun(sim, ev.task);																								//Quantum expired, back of the run queue
+        STAT(sim.stats.requeues++;)
+    }
+    if (sim.trace){																											//Let in the trace tasks that arrived meanwhile
+        admitArrivals(sim);
+    }
+}
+
+/***************************************************************************
+* template <int FIT> void runShortest(struct simEngine &sim)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs the task with the shortest remaining time, the top of the
+               ready heap, until it finishes or the next trace task arrives,
+               whichever is first. On an arrival the task's remaining time is
+               lowered in place and the newcomers are placed right away, so one
+               shorter than what is left of the running task goes on top and
+               preempts it at the next call. A dispatch is counted whenever the
+               top is not the task that ran last.
+* Parameters:
+* sim   I/P struct simEngine - The engine holding the run state
+* FIT   I/P int - Placement algorithm of the memory
+***************************************************************************/
+
+template <int FIT>
+void runShortest(struct simEngine &sim){
+    int loc = sim.ready[0].task;
+    long long remaining = sim.ready[0].key;
+    if (loc != sim.running){																								//Newly started or preempting
+        STAT(if (sim.running != -1)
+                 sim.stats.preemptions++;)
+        sim.dispatches++;
+        sim.running = loc;
+        if (sim.process->spent[loc] == 0){																					//First time the task runs
+            sim.process->started[loc] = sim.clock;
+        }
+    }
+    long long finish = sim.clock + remaining;
+    if (sim.trace && sim.generated < sim.total && sim.pending < sim.window
+        && (long long)sim.trace[sim.generated].arrival < finish){															//A task arrives before this one finishes
+        long long arrival = max((long long)sim.trace[sim.generated].arrival, sim.clock);									//A task that waited for room in the window arrives now
+        sim.process->spent[loc] += arrival - sim.clock;
+        decreaseKey(sim, loc, finish - arrival);
+        sim.clock = arrival;
+        int before = sim.pending, oldTail = sim.tail;
+        admitArrivals(sim);
+        if (before > 0){																									//Start the pending scan at the newcomers, memory has not changed for the rest
+            sim.prevPending = oldTail;
+        }
+        for (int fresh = sim.pending - before; fresh > 0 && sim.pending > 0; fresh--){
+            placeNext<BY_REMAINING, FIT>(sim);
+        }
+        return;
+    }
+    sim.clock = finish;
+    sim.process->spent[loc] += remaining;
+    sim.ready[0] = sim.ready.back();																						//Take the finished task off the heap
+    sim.ready.pop_back();
+    sim.readyPos[loc] = -1;
+    if (!sim.ready.empty())
+        siftReady(sim, 0);
+    sim.running = -1;
+    completeTask<FIT>(sim, loc);
+    if (sim.trace){																											//Let in the trace tasks that arrived meanwhile
+        admitArrivals(sim);
+    }
+}
+
+/***************************************************************************
+* template <int P, int FIT> void schedule(struct runArena &arena, struct taskSource &source, int q, struct results &res)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs the scheduling loop shared by every policy. Tasks from the
+               task source are placed into memory and the policy picks the next
+               one to run until every task is done. The policy and placement are
+               template parameters, so each pair gets its own copy of the loop
+               with the ready queue order, the event type and the fit all known
+               at compile time.
+* Parameters:
+* arena     I/P struct runArena - Memory blocks set up for the run and the buffers it reuses
+* source    I/P struct taskSource - Where the tasks come from
+* q         I/P int - Round robin quantum, unused by the other policies
+* res       O/P struct results - Where the avg turn around times are stored
+* P         I/P int - The policy, FCFS_POLICY, RR_POLICY, SPN_POLICY, SRT_POLICY, HRRN_POLICY or MLFQ_POLICY
+* FIT       I/P int - Placement the memory was set up with, see placementOf
+***************************************************************************/
+
+template <int P, int FIT>
+void schedule(struct runArena &arena, struct taskSource &source, int q, struct results &res){
+    const int ORDER = P == FCFS_POLICY ? BY_RECEIVED : P == RR_POLICY ? ROUND_ROBIN : P == SRT_POLICY ? BY_REMAINING
+                    : P == HRRN_POLICY ? BY_RESPONSE_RATIO : P == MLFQ_POLICY ? FEEDBACK : BY_DURATION;
+    const int EVENT = P == RR_POLICY ? QUANTUM_EXPIRE : P == MLFQ_POLICY ? LEVEL_EXPIRE : TASK_COMPLETE;
+    struct simEngine &sim = arena.sim;
+    initSim(sim, arena.mem, source, arena.process);
+    sim.quantum = q;
+    while (sim.pending > 0 || sim.resident > 0 || sim.generated < sim.total){												//Loop until all tasks are processed
+        if (sim.pending == 0 && sim.resident == 0){																			//Idle until the next trace task arrives
+            waitArrival(sim);
+            continue;
+        }
+        STAT(chrono::steady_clock::time_point started = chrono::steady_clock::now();)
+        bool placed = sim.pending > 0 && placeNext<ORDER, FIT>(sim);
+        STAT(sim.stats.placeNs += elapsedNs(started);)
+        if (placed){																										//Place the next pending task
+            continue;
+        }
+        STAT(if (sim.pending > 0)
+                 sim.stats.forcedDispatches++;)
+        if constexpr (ORDER == BY_REMAINING){																				//Srt runs until the next arrival or completion itself
+            STAT(started = chrono::steady_clock::now();)
+            runShortest<FIT>(sim);
+            STAT(sim.stats.eventNs += elapsedNs(started);)
+            continue;
+        }
+        STAT(started = chrono::steady_clock::now();)
+        int location;
+        if constexpr (ORDER == ROUND_ROBIN){
+            location = popRun(sim);																							//Take the process at the front of the run queue
+        }
+        else if constexpr (ORDER == BY_RESPONSE_RATIO){
+            location = popHighestRatio(sim);
+        }
+        else if constexpr (ORDER == FEEDBACK){
+            location = popFeedback(sim);
+        }
+        else {
+            location = popReady(sim);																						//Smallest received time for fcfs, shortest service time for spn
+        }
+        STAT(sim.stats.selectNs += elapsedNs(started);
+             started = chrono::steady_clock::now();)
+        dispatch<EVENT>(sim, location);
+        nextEvent<EVENT, FIT>(sim);
+        STAT(sim.stats.eventNs += elapsedNs(started);)
+    }
+    storeResults(sim, res);																									//Avg turn around time and relative turn around time
+}
+
+#endif
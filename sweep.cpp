@@ -0,0 +1,426 @@
+/***************************************************************************
+* File: sweep.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Runs fcfs, rr, spn, srt, hrrn and mlfq over a grid or a list of configurations, each a memory
+          layout, placement, quantum, size and duration distribution and task count, and
+          writes one table with the avg turn around times of every configuration and policy.
+
+* parseDist, parseFit, parseInts - Read the values of the grid options.
+
+* readList - Reads a list of configurations from a file.
+
+* checkPoint - Checks that every task of a configuration fits into its memory.
+
+* Build: g++ -O2 -std=c++17 -pthread sweep.cpp simulator.cpp -o sweep
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+
+struct sweepPoint {																											//Structure to hold one configuration of the sweep
+    struct simConfig config;																								//Memory layout, placement, quantum, distribution and task count
+    string layout;																											//Memory layout as given, for the table
+};
+
+const char *fitNames[] = {"first", "next", "best", "worst"};
+const char *policyNames[POLICIES] = {"fcfs", "rr", "spn", "srt", "hrrn", "mlfq"};
+
+/***************************************************************************
+* bool parseDist(const char *text, int &loops, int &ulimit)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads a size and duration distribution of the form loops x ulimit,
+               such as 4x4, the amount of uniform values summed and their max.
+* Parameters:
+* text      I/P const char * - The distribution
+* loops     O/P int - Uniform values summed per value
+* ulimit    O/P int - Max of each uniform value
+* parseDist O/P bool - False if the text is not a distribution
+***************************************************************************/
+
+bool parseDist(const char *text, int &loops, int &ulimit)
+{
+    char rest;
+    if (sscanf(text, "%dx%d%c", &loops, &ulimit, &rest) != 2)
+        return false;
+    return loops >= 1 && ulimit >= 1;
+}
+
+/***************************************************************************
+* int parseFit(const char *text)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads a placement algorithm by name.
+* Parameters:
+* text      I/P const char * - first, next, best or worst
+* parseFit  O/P int - The placement algorithm, -1 if the name is unknown
+***************************************************************************/
+
+int parseFit(const char *text)
+{
+    for (int f = FIRST_FIT; f <= WORST_FIT; f++){
+        if (strcmp(text, fitNames[f]) == 0)
+            return f;
+    }
+    return -1;
+}
+
+/***************************************************************************
+* bool parseInts(const char *text, vector<long long> &values)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads a comma separated list of positive integers and adds them to
+               values.
+* Parameters:
+* text      I/P const char * - The list
+* values    O/P vector<long long> - Where the integers are added
+* parseInts O/P bool - False if an entry is not a positive integer
+***************************************************************************/
+
+bool parseInts(const char *text, vector<long long> &values)
+{
+    while (true){
+        char *end;
+        long long v = strtoll(text, &end, 0);
+        if (end == text || v < 1 || (*end != ',' && *end != '\0'))
+            return false;
+        values.push_back(v);
+        if (*end == '\0')
+            return true;
+        text = end + 1;
+    }
+}
+
+/***************************************************************************
+* bool readList(const char *path, const struct sweepPoint &base, vector<struct sweepPoint> &points)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Reads one configuration per line of the form
+               b=16,16,16,8 f=best q=2 d=4x4 n=1000. Settings left out of a line
+               are taken from base, blank lines and lines starting with # are
+               skipped.
+* Parameters:
+* path      I/P const char * - The list file
+* base      I/P struct sweepPoint - Settings of a line that does not give them
+* points    O/P vector<struct sweepPoint> - Where the configurations are added
+* readList  O/P bool - False if the file cannot be read or a line is bad
+***************************************************************************/
+
+bool readList(const char *path, const struct sweepPoint &base, vector<struct sweepPoint> &points)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL){
+        cout << "Cannot read " << path << endl;
+        return false;
+    }
+    char *line = NULL;																										//Grown by getline to hold the longest line, so no line is split
+    size_t cap = 0;
+    int lineNo = 0;
+    bool ok = true;
+    while (ok && getline(&line, &cap, in) != -1){
+        lineNo++;
+        struct sweepPoint point = base;
+        int settings = 0;
+        for (char *word = strtok(line, " \t\r\n"); word != NULL; word = strtok(NULL, " \t\r\n")){
+            if (word[0] == '#' && settings == 0)
+                break;
+            vector<long long> values;
+            if (strncmp(word, "b=", 2) == 0 && parseBlocks(word + 2, point.config.blocks)){
+                point.layout = word + 2;
+            }
+            else if (strncmp(word, "f=", 2) == 0 && parseFit(word + 2) != -1){
+                point.config.fit = parseFit(word + 2);
+            }
+            else if (strncmp(word, "q=", 2) == 0 && parseInts(word + 2, values) && values.size() == 1 && values[0] <= INT_MAX){
+                point.config.quantum = values[0];
+            }
+            else if (strncmp(word, "d=", 2) == 0 && parseDist(word + 2, point.config.loops, point.config.ulimit)){
+            }
+            else if (strncmp(word, "n=", 2) == 0 && parseInts(word + 2, values) && values.size() == 1){
+                point.config.tasks = values[0];
+            }
+            else {
+                cout << path << " line " << lineNo << ": bad setting " << word << endl;
+                ok = false;
+                break;
+            }
+            settings++;
+        }
+        if (ok && settings > 0)
+            points.push_back(point);
+    }
+    free(line);
+    fclose(in);
+    return ok;
+}
+
+/***************************************************************************
+* bool checkPoint(const struct sweepPoint &point)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Checks that the largest task the distribution can draw fits into
+               the largest memory block and into 16 bits, and that the task
+               stream can be generated up front unless a window is set.
+* Parameters:
+* point         I/P struct sweepPoint - The configuration
+* checkPoint    O/P bool - False if the configuration cannot be run
+***************************************************************************/
+
+bool checkPoint(const struct sweepPoint &point)
+{
+    const struct simConfig &config = point.config;
+    long long biggest = max(1LL, (long long)config.loops * (config.ulimit - 1));
+    int largest = *max_element(config.blocks.begin(), config.blocks.end());
+    if (biggest > UINT16_MAX){
+        cout << "Distribution " << config.loops << "x" << config.ulimit << " draws values over 16 bits" << endl;
+        return false;
+    }
+    if (biggest > largest){
+        cout << "Memory layout " << point.layout << " cannot hold a task of size " << biggest << endl;
+        return false;
+    }
+    if (config.window == 0 && config.tasks > INT_MAX){
+        cout << "Task streams this long need streaming mode, use -w <window>" << endl;
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* int main( int argc, char *argv[] )
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Builds every combination of the grid options, or reads a list of
+               configurations, and runs each one's experiments. Every
+               (configuration, experiment, policy) triple is a job for the one
+               thread pool, and the policies of an experiment share its task
+               stream, which is generated once by whichever runs first. Experiment
+               k is seeded the same in every configuration, so configurations
+               with the same distribution and task count see the same streams.
+               Writes one CSV row per configuration and policy with the avg turn
+               around times and the half widths of their 95% confidence intervals.
+               With a cache directory the results of each experiment are kept per
+               configuration and policy, and only those the cache does not have
+               are simulated.
+* Parameters:
+* argc I/P int The number of arguments on the command line
+* argv I/P char *[] The arguments on the command line, -b <blocks> a memory layout, given once
+                    per layout, and comma separated lists -f <fits>, -q <quanta>,
+                    -d <loops x ulimit> and -n <tasks> make up the grid. -l <file>
+                    reads a list of configurations instead, -k <experiments> the
+                    experiments per configuration, -w <window> turns on streaming,
+                    -t <threads> the amount of worker threads, -s <seed> the seed,
+                    -o <file> where to write the table and -C <dir> a result cache
+* main O/P int 0, or 1 on a bad option or configuration
+**************************************************************************/
+
+int main(int argc, char *argv[])
+{
+    vector<string> layouts;																									//Grid of memory layouts, placements, quanta, distributions and task counts
+    vector<int> fits;
+    vector<long long> quanta, tasks;
+    vector<pair<int, int>> dists;
+    const char *listPath = NULL;
+    const char *outPath = NULL;
+    const char *cacheDir = NULL;
+    int reps = 50;
+    int window = 0;
+    int threads = thread::hardware_concurrency();
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++){
+        bool ok = true;
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc){
+            vector<int> blocks;
+            ok = parseBlocks(argv[++i], blocks);
+            layouts.push_back(argv[i]);
+        }
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc){
+            string names = argv[++i];																						//A copy as long as the list, strtok writes into it
+            for (char *name = strtok(&names[0], ","); name != NULL && ok; name = strtok(NULL, ",")){
+                fits.push_back(parseFit(name));
+                ok = fits.back() != -1;
+            }
+        }
+        else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc){
+            ok = parseInts(argv[++i], quanta) && *max_element(quanta.begin(), quanta.end()) <= INT_MAX;
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc){
+            string list = argv[++i];																						//A copy as long as the list, strtok writes into it
+            for (char *dist = strtok(&list[0], ","); dist != NULL && ok; dist = strtok(NULL, ",")){
+                int loops, ulimit;
+                ok = parseDist(dist, loops, ulimit);
+                dists.push_back(make_pair(loops, ulimit));
+            }
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            ok = parseInts(argv[++i], tasks);
+        }
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc){
+            listPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc){
+            reps = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc){
+            window = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc){
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc){
+            seed = strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+            outPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc){
+            cacheDir = argv[++i];
+        }
+        if (!ok){
+            cout << "Bad value " << argv[i] << " for " << argv[i - 1] << endl;
+            return 1;
+        }
+    }
+    if (reps < 1 || window < 0){
+        cout << "Experiments must be at least 1 and the window cannot be negative" << endl;
+        return 1;
+    }
+    if (layouts.empty())																									//Settings of the original program where the grid leaves them out
+        layouts.push_back("16,16,16,8");
+    if (fits.empty())
+        fits.push_back(FIRST_FIT);
+    if (quanta.empty())
+        quanta.push_back(1);
+    if (dists.empty())
+        dists.push_back(make_pair(4, 4));
+    if (tasks.empty())
+        tasks.push_back(1000);
+
+    vector<struct sweepPoint> points;
+    struct sweepPoint base;
+    base.layout = layouts[0];
+    parseBlocks(base.layout.c_str(), base.config.blocks);
+    base.config.fit = fits[0];
+    base.config.quantum = quanta[0];
+    base.config.loops = dists[0].first;
+    base.config.ulimit = dists[0].second;
+    base.config.tasks = tasks[0];
+    base.config.window = window;
+    if (listPath){
+        if (!readList(listPath, base, points))
+            return 1;
+    }
+    else {
+        for (const string &layout : layouts){																				//Every combination of the grid
+            for (int fit : fits){
+                for (long long quantum : quanta){
+                    for (const pair<int, int> &dist : dists){
+                        for (long long n : tasks){
+                            struct sweepPoint point = base;
+                            point.layout = layout;
+                            parseBlocks(layout.c_str(), point.config.blocks);
+                            point.config.fit = fit;
+                            point.config.quantum = quantum;
+                            point.config.loops = dist.first;
+                            point.config.ulimit = dist.second;
+                            point.config.tasks = n;
+                            points.push_back(point);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (const struct sweepPoint &point : points){
+        if (!checkPoint(point))
+            return 1;
+    }
+    if ((long long)points.size() * reps * POLICIES > INT_MAX){
+        cout << "Too many jobs, use fewer configurations or experiments" << endl;
+        return 1;
+    }
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (out == NULL){
+        cout << "Cannot write " << outPath << endl;
+        return 1;
+    }
+
+    if (threads < 1)
+        threads = 1;
+    int configs = points.size();
+    vector<struct runArena> arenas(threads);																				//Buffers reused by each worker
+    vector<struct results> slots((size_t)configs * reps * POLICIES);														//One result slot per (configuration, experiment, policy)
+    vector<int> have(configs * POLICIES, 0);																				//Experiments of each configuration and policy the cache had
+    vector<uint64_t> keys(configs * POLICIES);
+    vector<struct results> cached;
+    for (int c = 0; c < configs && cacheDir; c++){																			//Take what the cache has
+        for (int p = 0; p < POLICIES; p++){
+            keys[c * POLICIES + p] = resultKey(points[c].config, p, seed);
+            have[c * POLICIES + p] = min(reps, loadResults(cacheDir, keys[c * POLICIES + p], cached));
+            for (int r = 0; r < have[c * POLICIES + p]; r++){
+                slots[((size_t)c * reps + r) * POLICIES + p] = cached[r];
+            }
+        }
+    }
+    vector<struct workload> works(window > 0 ? 0 : (size_t)configs * reps);													//Task stream of each experiment, unused when streaming
+    vector<int> jobs;																										//Slots still to simulate
+    for (int c = 0; c < configs; c++){
+        for (int r = 0; r < reps; r++){
+            for (int p = 0; p < POLICIES; p++){
+                if (r < have[c * POLICIES + p])
+                    continue;
+                if (!canBatch(p, points[c].config) || (r - have[c * POLICIES + p]) % BATCH_LANES == 0)						//A batch job stands for BATCH_LANES experiments
+                    jobs.push_back((c * reps + r) * POLICIES + p);
+                if (window == 0)																							//Only the policies that run share the task stream
+                    works[c * reps + r].users++;
+            }
+        }
+    }
+    struct workload unused;
+    runJobs(jobs.size(), threads, [&](int job, int worker){
+        int slot = jobs[job];
+        int experiment = slot / POLICIES;																					//Configuration and experiment number of the job
+        const struct simConfig &config = points[experiment / reps].config;
+        if (canBatch(slot % POLICIES, config))
+            runBatch(seed, experiment % reps, min(BATCH_LANES, reps - experiment % reps), &works[experiment], slot % POLICIES, config,
+                     arenas[worker], &slots[slot], POLICIES);
+        else
+            runExperiment(seed, experiment % reps, window > 0 ? unused : works[experiment], slot % POLICIES, config, arenas[worker], slots[slot]);
+    });
+    for (int c = 0; c < configs && cacheDir; c++){																			//Keep the new results
+        for (int p = 0; p < POLICIES; p++){
+            if (have[c * POLICIES + p] == reps)
+                continue;
+            cached.resize(reps);
+            for (int r = 0; r < reps; r++){
+                cached[r] = slots[((size_t)c * reps + r) * POLICIES + p];
+            }
+            if (!saveResults(cacheDir, keys[c * POLICIES + p], cached))
+                cerr << "Cannot write to the cache in " << cacheDir << endl;
+        }
+    }
+    if (cacheDir){
+        cerr << (long long)configs * reps * POLICIES - (long long)jobs.size() << " of " << (long long)configs * reps * POLICIES
+             << " runs came from the cache" << endl;
+    }
+
+    fprintf(out, "layout,fit,quantum,dist,tasks,policy,experiments,avg_tat,tat_ci95,avg_rtat,rtat_ci95\n");
+    for (int c = 0; c < configs; c++){																						//Rows in configuration order
+        const struct simConfig &config = points[c].config;
+        for (int p = 0; p < POLICIES; p++){
+            struct welford ta, rta;
+            for (int r = 0; r < reps; r++){
+                const struct results &res = slots[((size_t)c * reps + r) * POLICIES + p];
+                addSample(ta, res.ttat);
+                addSample(rta, res.rtat);
+            }
+            fprintf(out, "\"%s\",%s,%d,%dx%d,%lld,%s,%d,%.4f,%.4f,%.4f,%.4f\n",
+                    points[c].layout.c_str(), fitNames[config.fit], config.quantum, config.loops, config.ulimit,
+                    config.tasks, policyNames[p], reps, ta.mean, reps > 1 ? ciHalfWidth(ta) : 0.0,
+                    rta.mean, reps > 1 ? ciHalfWidth(rta) : 0.0);
+        }
+    }
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
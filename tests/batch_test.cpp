@@ -0,0 +1,88 @@
+/***************************************************************************
+* File: batch_test.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Checks that the lock-step fcfs and spn batches give the same results
+          and latency sketches as running every experiment on its own.
+
+* checkLayout - Compares runBatch with runExperiment on one memory layout.
+
+* Build: g++ -O2 -std=c++17 -pthread -I. tests/batch_test.cpp simulator.cpp -o batch_test
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+
+/***************************************************************************
+* int checkLayout(const char *layout, int fit, int p, int loops, int ulimit)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Generates the task streams of a round of experiments twice,
+               runs one copy an experiment at a time and the other in
+               batches, and counts the experiments whose results differ.
+* Parameters:
+* layout      I/P const char * - The memory layout
+* fit         I/P int - The placement algorithm
+* p           I/P int - FCFS_POLICY or SPN_POLICY
+* loops       I/P int - Uniform values summed per task size or duration
+* ulimit      I/P int - Max of each uniform value
+* checkLayout O/P int - The experiments whose results differ, or -1 if the
+                        configuration cannot be batched
+***************************************************************************/
+
+int checkLayout(const char *layout, int fit, int p, int loops, int ulimit)
+{
+    const int experiments = 2 * BATCH_LANES + 1;																			//Leaves a short last batch
+    const uint64_t seed = 7;
+    struct simConfig config;
+    parseBlocks(layout, config.blocks);
+    config.fit = fit;
+    config.tasks = 300;
+    config.loops = loops;
+    config.ulimit = ulimit;
+    if (!canBatch(p, config))
+        return -1;
+    vector<struct workload> single(experiments), batched(experiments);
+    vector<struct results> expected(experiments), actual(experiments);
+    double genNs = 0;
+    for (int k = 0; k < experiments; k++){
+        single[k].users = 1;
+        batched[k].users = 1;
+        generateWork(seed, k, single[k], config, genNs);
+        generateWork(seed, k, batched[k], config, genNs);
+    }
+    struct runArena one, lockStep;
+    for (int k = 0; k < experiments; k++)
+        runExperiment(seed, k, single[k], p, config, one, expected[k]);
+    for (int k = 0; k < experiments; k += BATCH_LANES)
+        runBatch(seed, k, min(BATCH_LANES, experiments - k), &batched[k], p, config, lockStep, &actual[k], 1);
+    int bad = 0;
+    for (int k = 0; k < experiments; k++)
+        bad += memcmp(&expected[k], &actual[k], sizeof(struct results)) != 0;
+    bad += memcmp(&one.sketch[p], &lockStep.sketch[p], sizeof(struct latencySketch)) != 0;
+    return bad;
+}
+
+int main()
+{
+    const char *layouts[] = {"16,16,16,8", "16,8", "2x16,8,4,4,1,3", "32,32", "64"};
+    const int dists[][2] = {{4, 4}, {2, 8}, {1, 2}};																		//Small tasks fill every slot of a 64 block memory
+    int failures = 0, checked = 0;
+    for (const char *layout : layouts){
+        for (int fit = 0; fit < FITS; fit++){
+            for (int p : {FCFS_POLICY, SPN_POLICY}){
+                for (const auto &dist : dists){
+                    int bad = checkLayout(layout, fit, p, dist[0], dist[1]);
+                    if (bad < 0)
+                        continue;
+                    checked++;
+                    if (bad > 0){
+                        printf("FAIL layout %s fit %d policy %d dist %dx%d: %d differ\n", layout, fit, p, dist[0], dist[1], bad);
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+    printf("batch_test: %d of %d configurations differ\n", failures, checked);
+    return failures > 0 || checked == 0;
+}
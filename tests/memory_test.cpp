@@ -0,0 +1,325 @@
+/***************************************************************************
+* File: memory_test.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Checks the holes and buddy memory models against plain reference
+          models over random sequences of placements and releases, and that
+          compaction slides every task down and leaves one hole at the top.
+
+* nextRandom - Draws a number below n from a xorshift generator.
+
+* findHole - Calls the findBlock copy of the holes model for a placement algorithm.
+
+* checkHoles - Runs random placements and releases on the holes model.
+
+* checkBuddies - Runs random placements and releases on the buddy system.
+
+* checkCompaction - Compacts a memory with holes between its tasks.
+
+* Build: g++ -O2 -std=c++17 -pthread -I. tests/memory_test.cpp simulator.cpp -o memory_test
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+#include <map>
+
+/***************************************************************************
+* int nextRandom(uint64_t &x, int n)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Steps a xorshift generator and returns its state modulo n.
+* Parameters:
+* x          I/P uint64_t - The generator state, not 0
+* n          I/P int - Bound of the number drawn
+* nextRandom O/P int - A number from 0 to n-1
+***************************************************************************/
+
+int nextRandom(uint64_t &x, int n)
+{
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x % n;
+}
+
+/***************************************************************************
+* int findHole(struct memoryMap &mem, int size)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Picks the hole for a task with the copy of findBlock the engine
+               uses for the holes model and the memory's fit.
+* Parameters:
+* mem       I/P struct memoryMap - The memory, set up by setHoles
+* size      I/P int - The size of the task
+* findHole  O/P int - The start of the hole, -1 if none holds the task
+***************************************************************************/
+
+int findHole(struct memoryMap &mem, int size)
+{
+    switch (mem.fit){
+    case FIRST_FIT:
+        return findBlock<FREE_LIST * FITS + FIRST_FIT>(mem, size);
+    case NEXT_FIT:
+        return findBlock<FREE_LIST * FITS + NEXT_FIT>(mem, size);
+    case BEST_FIT:
+        return findBlock<FREE_LIST * FITS + BEST_FIT>(mem, size);
+    default:
+        return findBlock<FREE_LIST * FITS + WORST_FIT>(mem, size);
+    }
+}
+
+/***************************************************************************
+* int checkHoles(uint64_t &x, int size, int fit, int steps)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Places and frees random tasks on the holes model and on a map
+               of holes searched one by one. Every placement has to pick the
+               same hole, and after every step the free space, the boundary
+               tags, the tree leaves and the best fit index have to agree with
+               the map.
+* Parameters:
+* x          I/P uint64_t - The generator state
+* size       I/P int - Addresses in the memory
+* fit        I/P int - The placement algorithm
+* steps      I/P int - Placements and releases to make
+* checkHoles O/P int - 1 if the models parted, 0 otherwise
+***************************************************************************/
+
+int checkHoles(uint64_t &x, int size, int fit, int steps)
+{
+    struct memoryMap mem;
+    setHoles(mem, size, fit);
+    map<int, int> holes{{0, size}}, tasks;																					//Start to length of each hole and each task
+    int next = 0;																											//Where the next fit search of the reference starts
+    for (int step = 0; step < steps; step++){
+        if (tasks.empty() || nextRandom(x, 3) != 0){
+            int want = 1 + nextRandom(x, min(size, 40));
+            int j = findHole(mem, want);
+            int ref = -1, refLen = fit == BEST_FIT ? INT_MAX : 0;
+            for (int lap = 0; lap < 2 && ref == -1; lap++){																	//Next fit looks past the last placement first
+                for (const auto &hole : holes){
+                    if (hole.second < want || (fit == NEXT_FIT && lap == 0 && hole.first < next))
+                        continue;
+                    if (fit == FIRST_FIT || fit == NEXT_FIT){
+                        ref = hole.first;
+                        break;
+                    }
+                    if ((fit == BEST_FIT && hole.second < refLen) || (fit == WORST_FIT && hole.second > refLen)){
+                        ref = hole.first;
+                        refLen = hole.second;
+                    }
+                }
+            }
+            if (j != ref){
+                printf("FAIL holes of %d, fit %d: a task of %d went to %d instead of %d\n", size, fit, want, j, ref);
+                return 1;
+            }
+            if (j == -1)
+                continue;
+            next = j;
+            takeHole(mem, j, want);
+            int len = holes[j];
+            holes.erase(j);
+            if (len > want)
+                holes[j + want] = len - want;
+            tasks[j] = want;
+        }
+        else {
+            auto task = tasks.begin();
+            advance(task, nextRandom(x, tasks.size()));
+            int start = task->first, len = task->second;
+            tasks.erase(task);
+            giveHole(mem, start, len);
+            auto after = holes.find(start + len);																			//Merge with the holes on both sides
+            if (after != holes.end()){
+                len += after->second;
+                holes.erase(after);
+            }
+            auto before = holes.lower_bound(start);
+            if (before != holes.begin() && prev(before)->first + prev(before)->second == start){
+                before--;
+                start = before->first;
+                len += before->second;
+                holes.erase(before);
+            }
+            holes[start] = len;
+        }
+        int free = 0;
+        for (const auto &hole : holes)
+            free += hole.second;
+        bool same = free == mem.freeSpace && (fit != BEST_FIT || mem.bySize.size() == holes.size());
+        for (int a = 0; a < size && same; a++){
+            auto hole = holes.find(a);
+            int len = hole == holes.end() ? 0 : hole->second;
+            same = mem.holeLen[a] == len && mem.tree[mem.leaves + a] == len && (len == 0 || mem.holeStart[a + len - 1] == a);
+        }
+        if (!same){
+            printf("FAIL holes of %d, fit %d: the index parted from the holes after step %d\n", size, fit, step);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+* int checkBuddies(uint64_t &x, int size, int steps)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Places and frees random tasks on the buddy system and marks the
+               addresses they take in a bitmap. A placement has to succeed
+               exactly when the bitmap has a free aligned block of the task's
+               order or larger, and land on a free aligned block. Once every
+               task is freed the memory has to have merged back into the
+               largest aligned blocks that tile it.
+* Parameters:
+* x            I/P uint64_t - The generator state
+* size         I/P int - Addresses in the memory
+* steps        I/P int - Placements and releases to make
+* checkBuddies O/P int - 1 if the models parted, 0 otherwise
+***************************************************************************/
+
+int checkBuddies(uint64_t &x, int size, int steps)
+{
+    struct memoryMap mem;
+    setBuddies(mem, size);
+    int span = 1 << mem.orders;
+    vector<char> busy(span, 0);
+    fill(busy.begin() + size, busy.end(), 1);																				//Past the total is never free
+    map<int, int> tasks;
+    for (int step = 0; step < steps; step++){
+        if (tasks.empty() || nextRandom(x, 3) != 0){
+            int want = 1 + nextRandom(x, min(size, 64));
+            int k = buddyOrder(want);
+            bool fits = false;
+            for (int order = k; order <= mem.orders && !fits; order++){
+                for (int a = 0; a < span && !fits; a += 1 << order)
+                    fits = find(busy.begin() + a, busy.begin() + a + (1 << order), 1) == busy.begin() + a + (1 << order);
+            }
+            int j = findBlock<BUDDY_SYSTEM * FITS>(mem, want);
+            if ((j != -1) != fits){
+                printf("FAIL buddies of %d: a task of %d %s\n", size, want, fits ? "found no block" : "found a block that is not free");
+                return 1;
+            }
+            if (j == -1)
+                continue;
+            if (j % (1 << k) != 0 || find(busy.begin() + j, busy.begin() + j + (1 << k), 1) != busy.begin() + j + (1 << k)){
+                printf("FAIL buddies of %d: a task of %d went to %d, not a free aligned block\n", size, want, j);
+                return 1;
+            }
+            takeBuddy(mem, j, want);
+            fill(busy.begin() + j, busy.begin() + j + (1 << k), 1);
+            tasks[j] = want;
+        }
+        else {
+            auto task = tasks.begin();
+            advance(task, nextRandom(x, tasks.size()));
+            giveBuddy(mem, task->first, task->second);
+            fill(busy.begin() + task->first, busy.begin() + task->first + (1 << buddyOrder(task->second)), 0);
+            tasks.erase(task);
+        }
+    }
+    for (const auto &task : tasks)
+        giveBuddy(mem, task.first, task.second);
+    if (mem.freeSpace != size){
+        printf("FAIL buddies of %d: %d free once every task left\n", size, mem.freeSpace);
+        return 1;
+    }
+    for (int order = mem.orders, a = 0; order >= 0; order--){																//Largest blocks first, like the layout is split
+        if (a + (1 << order) > size)
+            continue;
+        if (mem.freeOrder[a] != order){
+            printf("FAIL buddies of %d: the block at %d did not merge back to order %d\n", size, a, order);
+            return 1;
+        }
+        a += 1 << order;
+    }
+    return 0;
+}
+
+/***************************************************************************
+* int checkCompaction(int fit)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Fills a memory with tasks, frees every other one so no hole
+               holds a task of twice their size, and compacts it. The tasks
+               left have to keep their order from address 0 up with their
+               new addresses recorded, one hole has to hold the rest of the
+               memory, and the clock has to move on by the cost of every unit
+               that moved.
+* Parameters:
+* fit             I/P int - The placement algorithm
+* checkCompaction O/P int - 1 if the compacted memory is wrong, 0 otherwise
+***************************************************************************/
+
+int checkCompaction(int fit)
+{
+    const int size = 100, tasks = 10, cost = 3;
+    struct memoryMap mem;
+    setHoles(mem, size, fit);
+    mem.compactCost = cost;
+    struct workload work;
+    struct taskState process;
+    work.size.assign(tasks, 0);
+    process.blockLoc.assign(tasks, -1);
+    for (int i = 0, start = 0; i < tasks; i++){																				//Sizes 5 to 14 from address 0 up
+        work.size[i] = 5 + i;
+        int j = findHole(mem, work.size[i]);
+        if (j != start){
+            printf("FAIL compaction, fit %d: task %d went to %d instead of %d\n", fit, i, j, start);
+            return 1;
+        }
+        takeHole(mem, j, work.size[i]);
+        mem.owner[j] = i;
+        process.blockLoc[i] = j;
+        start += work.size[i];
+    }
+    for (int i = 0; i < tasks; i += 2){
+        giveHole(mem, process.blockLoc[i], work.size[i]);
+    }
+    int want = 2 * work.size[tasks - 1];
+    if (findHole(mem, want) != -1){
+        printf("FAIL compaction, fit %d: a task of %d fits before compacting\n", fit, want);
+        return 1;
+    }
+    struct simEngine sim;
+    sim.mem = &mem;
+    sim.work = &work;
+    sim.process = &process;
+    sim.clock = 0;
+    int free = mem.freeSpace;
+    compactMemory(sim);
+    long long moved = 0;
+    int bottom = 0;
+    for (int i = 1; i < tasks; i += 2){
+        if (process.blockLoc[i] != bottom || mem.owner[bottom] != i){
+            printf("FAIL compaction, fit %d: task %d is at %d instead of %d\n", fit, i, process.blockLoc[i], bottom);
+            return 1;
+        }
+        moved += work.size[i];																								//Every kept task was above a freed one
+        bottom += work.size[i];
+    }
+    if (mem.freeSpace != free || mem.holeLen[bottom] != size - bottom || mem.tree[1] != size - bottom
+        || (fit == BEST_FIT && mem.bySize.size() != 1) || sim.clock != cost * moved){
+        printf("FAIL compaction, fit %d: the hole at the top or the clock is wrong\n", fit);
+        return 1;
+    }
+    if (findHole(mem, want) != bottom){
+        printf("FAIL compaction, fit %d: a task of %d does not go to the hole at the top\n", fit, want);
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    uint64_t x = 88172645463325252ULL;
+    int failures = 0;
+    for (int trial = 0; trial < 200; trial++){
+        failures += checkHoles(x, 1 + nextRandom(x, 300), nextRandom(x, FITS), 400);
+        failures += checkBuddies(x, 1 + nextRandom(x, 500), 400);
+    }
+    for (int fit = 0; fit < FITS; fit++){
+        failures += checkCompaction(fit);
+    }
+    printf("memory_test: %d failures\n", failures);
+    return failures > 0;
+}
@@ -0,0 +1,94 @@
+/***************************************************************************
+* File: pipeline_test.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Checks that runPipeline gives every experiment and policy the same
+          results as running them one at a time, for any amount of threads,
+          and hands the batches to aggregate in experiment order.
+
+* checkPipeline - Compares runPipeline with runExperiment on one configuration.
+
+* Build: g++ -O2 -std=c++17 -pthread -I. tests/pipeline_test.cpp simulator.cpp -o pipeline_test
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+
+/***************************************************************************
+* int checkPipeline(const struct simConfig &config, int experiments, int threads)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Runs a round of experiments through the pipeline the way main
+               does and counts the results that differ from running every
+               experiment and policy on its own, plus the batches that were
+               aggregated out of order.
+* Parameters:
+* config        I/P struct simConfig - The configuration to run
+* experiments   I/P int - Experiments in the round
+* threads       I/P int - The amount of worker threads
+* checkPipeline O/P int - The results and batches that are wrong
+***************************************************************************/
+
+int checkPipeline(const struct simConfig &config, int experiments, int threads)
+{
+    const uint64_t seed = 11;
+    bool streaming = config.window > 0;
+    vector<struct results> expected(experiments * POLICIES);
+    struct runArena single;
+    for (int k = 0; k < experiments; k++){
+        struct workload work;
+        for (int p = 0; p < POLICIES; p++)
+            runExperiment(seed, k, work, p, config, single, expected[k * POLICIES + p]);
+    }
+
+    vector<struct results> slots(experiments * POLICIES);
+    vector<struct workload> works(streaming ? 0 : experiments);
+    vector<struct workBatch> batches((experiments + BATCH_LANES - 1) / BATCH_LANES);
+    for (int b = 0; b < (int)batches.size(); b++){
+        batches[b].first = b * BATCH_LANES;
+        batches[b].lanes = min(BATCH_LANES, experiments - b * BATCH_LANES);
+        batches[b].works = streaming ? NULL : &works[b * BATCH_LANES];
+        batches[b].res = &slots[b * BATCH_LANES * POLICIES];
+    }
+    vector<struct runArena> arenas(threads);
+    int next = 0, bad = 0;
+    runPipeline(batches, threads, seed, config, arenas, [&](struct workBatch &batch){
+        bad += batch.first != next;
+        next = batch.first + batch.lanes;
+    });
+    bad += next != experiments;
+    for (int i = 0; i < experiments * POLICIES; i++)
+        bad += memcmp(&expected[i], &slots[i], sizeof(struct results)) != 0;
+    return bad;
+}
+
+int main()
+{
+    struct simConfig fixed;
+    fixed.blocks = {16, 16, 16, 8};
+    fixed.tasks = 200;
+    struct simConfig wide = fixed;																							//Lock-step batches with every slot in use
+    wide.blocks = vector<int>(64, 2);
+    wide.loops = 1;
+    wide.ulimit = 2;
+    struct simConfig streamed = fixed;																						//Runs draw their own tasks
+    streamed.window = 16;
+    struct simConfig holes = fixed;
+    holes.model = FREE_LIST;
+    holes.fit = BEST_FIT;
+    const struct simConfig *configs[] = {&fixed, &wide, &streamed, &holes};
+    const char *names[] = {"fixed", "wide", "streamed", "holes"};
+    int failures = 0;
+    for (int c = 0; c < 4; c++){
+        for (int experiments : {1, 4, 23}){
+            for (int threads : {1, 2, 5}){
+                int bad = checkPipeline(*configs[c], experiments, threads);
+                if (bad > 0){
+                    printf("FAIL %s with %d experiments on %d threads: %d wrong\n", names[c], experiments, threads, bad);
+                    failures++;
+                }
+            }
+        }
+    }
+    printf("pipeline_test: %d failures\n", failures);
+    return failures > 0;
+}
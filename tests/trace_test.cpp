@@ -0,0 +1,184 @@
+/***************************************************************************
+* File: trace_test.cpp
+* Author: Venkata Bapanapalli
+* Procedures:
+* main  - Checks that openTrace maps a well formed trace, rejects damaged ones,
+          and that replaying a trace of tasks that all arrive at time 0 gives
+          the same results as running the generated task stream.
+
+* writeTrace - Writes a binary trace file the way csv2trace does.
+
+* checkCompactionReplay - Replays a trace through srt on holes that have to be compacted.
+
+* Build: g++ -O2 -std=c++17 -pthread -I. tests/trace_test.cpp simulator.cpp -o trace_test
+***************************************************************************/
+#include "simulator.h"
+#include <stdio.h>
+#include <unistd.h>
+
+/***************************************************************************
+* bool writeTrace(const char *path, struct traceHeader header, const vector<struct traceRecord> &records)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Writes a header followed by the records. The header is taken
+               as given so damaged files can be written too.
+* Parameters:
+* path       I/P const char * - The trace file
+* header     I/P struct traceHeader - The header to write
+* records    I/P vector<struct traceRecord> - The records to write
+* writeTrace O/P bool - False if the file cannot be written
+***************************************************************************/
+
+bool writeTrace(const char *path, struct traceHeader header, const vector<struct traceRecord> &records)
+{
+    FILE *out = fopen(path, "wb");
+    if (out == NULL)
+        return false;
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1
+              && fwrite(records.data(), sizeof(struct traceRecord), records.size(), out) == records.size();
+    return fclose(out) == 0 && ok;
+}
+
+/***************************************************************************
+* int checkCompactionReplay(const char *path)
+* Author: Venkata Bapanapalli
+* Date: 3 May 2020
+* Description: Replays seven tasks through srt on 12 units of holes compacted
+               at 100 time units per unit moved. Task 3 arrives at 2 and only
+               fits once tasks 0 and 2 slide down, which takes until 302.
+               Tasks 4 to 6 arrive during the compaction, so they are placed
+               at 302 and later, and task 0, preempted at 2, only goes on at
+               305. The turn around times, counted from placement, are 1 for
+               task 1, 354 for task 0, 414 for task 2, 1112 for task 3 and 1,
+               1 and 2 for tasks 4 to 6.
+* Parameters:
+* path                  I/P const char * - Where to write the trace
+* checkCompactionReplay O/P int - 1 if srt gives other times, 0 otherwise
+***************************************************************************/
+
+int checkCompactionReplay(const char *path)
+{
+    const int tasks[][3] = {{0, 3, 50}, {0, 3, 1}, {0, 3, 60}, {2, 4, 1000}, {3, 1, 1}, {4, 2, 1}, {5, 1, 1}};				//Arrival, size and service time
+    struct traceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(struct traceRecord);
+    header.count = 7;
+    header.maxSize = 4;
+    header.maxDuration = 1000;
+    vector<struct traceRecord> records(7);
+    for (int i = 0; i < 7; i++){
+        records[i].arrival = tasks[i][0];
+        records[i].size = tasks[i][1];
+        records[i].duration = tasks[i][2];
+    }
+    struct traceFile trace;
+    if (!writeTrace(path, header, records) || !openTrace(path, trace)){
+        printf("FAIL the compaction trace does not open\n");
+        return 1;
+    }
+    struct simConfig config;
+    config.blocks = {12};
+    config.model = FREE_LIST;
+    config.compactCost = 100;
+    config.tasks = 7;
+    config.trace = &trace;
+    struct runArena arena;
+    struct workload unused;
+    struct results res;
+    runExperiment(1, 0, unused, SRT_POLICY, config, arena, res);
+    closeTrace(trace);
+    double expected = (1 + 354 + 414 + 1112 + 1 + 1 + 2) / 7.0;
+    if (res.ttat != expected){
+        printf("FAIL srt with compaction gives an avg turn around time of %f instead of %f\n", res.ttat, expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    const char *policyNames[POLICIES] = {"fcfs", "rr", "spn", "srt", "hrrn", "mlfq"};
+    char path[] = "/tmp/trace_testXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0){
+        printf("Cannot create a temporary file\n");
+        return 1;
+    }
+    close(fd);
+    int failures = 0;
+
+    struct simConfig config;
+    config.blocks = {16, 16, 16, 8};
+    config.tasks = 500;
+    struct workload work;
+    work.users = 1;
+    double genNs = 0;
+    generateWork(3, 0, work, config, genNs);
+    struct traceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(struct traceRecord);
+    header.count = config.tasks;
+    header.maxSize = 0;
+    header.maxDuration = 0;
+    vector<struct traceRecord> records(config.tasks);
+    for (long long i = 0; i < config.tasks; i++){																			//Every task arrives at once, like a generated stream
+        records[i].arrival = 0;
+        records[i].size = work.size[i];
+        records[i].duration = work.duration[i];
+        header.maxSize = max(header.maxSize, records[i].size);
+        header.maxDuration = max(header.maxDuration, records[i].duration);
+    }
+
+    struct traceFile trace;
+    if (!writeTrace(path, header, records) || !openTrace(path, trace)){
+        printf("FAIL a well formed trace does not open\n");
+        unlink(path);
+        return 1;
+    }
+    if (trace.header->count != header.count || trace.header->maxSize != header.maxSize
+        || memcmp(trace.records, records.data(), records.size() * sizeof(struct traceRecord)) != 0){
+        printf("FAIL the mapped trace differs from the one written\n");
+        failures++;
+    }
+    struct simConfig replay = config;
+    replay.trace = &trace;
+    struct runArena generated, replayed;
+    for (int p = 0; p < POLICIES; p++){
+        struct workload again;
+        again.users = 1;
+        struct results expected, actual;
+        runExperiment(3, 0, again, p, config, generated, expected);
+        runExperiment(3, 0, again, p, replay, replayed, actual);
+        if (expected.ttat != actual.ttat || expected.rtat != actual.rtat){
+            printf("FAIL %s replays to %f %f instead of %f %f\n", policyNames[p], actual.ttat, actual.rtat, expected.ttat, expected.rtat);
+            failures++;
+        }
+    }
+    closeTrace(trace);
+    failures += checkCompactionReplay(path);
+
+    struct traceHeader bad = header;																						//Each damaged header has to be rejected
+    bad.magic[0] = 'X';
+    failures += writeTrace(path, bad, records) && openTrace(path, trace);
+    bad = header;
+    bad.version = TRACE_VERSION + 1;
+    failures += writeTrace(path, bad, records) && openTrace(path, trace);
+    bad = header;
+    bad.recordSize = sizeof(struct traceRecord) + 4;
+    failures += writeTrace(path, bad, records) && openTrace(path, trace);
+    bad = header;
+    bad.count = header.count + 1;																							//More records than the file holds
+    failures += writeTrace(path, bad, records) && openTrace(path, trace);
+    if (truncate(path, sizeof(struct traceHeader) - 1) == 0)
+        failures += openTrace(path, trace);
+    unlink(path);
+    failures += openTrace(path, trace);
+    if (trace.map != NULL || trace.fd >= 0){
+        printf("FAIL a rejected trace is left open\n");
+        failures++;
+    }
+    printf("trace_test: %d failures\n", failures);
+    return failures > 0;
+}